@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+#include "system/stacktrace.h"
+#include "aabb_tree.h"
+
+#define AABB_TREE_LEAF_SIZE 4
+// Median splits keep the depth within log2(count) + 1
+#define AABB_TREE_MAX_DEPTH 64
+
+typedef struct {
+    Rect rect;
+    size_t index;
+} Item;
+
+typedef struct {
+    Rect box;
+    // Leaf: items[first, first + count)
+    // Inner node: children are nodes[first] and nodes[first + 1]
+    size_t first;
+    size_t count;
+} Node;
+
+struct AabbTree
+{
+    Lt *lt;
+    size_t items_count;
+    Item *items;
+    size_t nodes_count;
+    Node *nodes;
+};
+
+static Rect rects_union(Rect a, Rect b)
+{
+    return rect_from_points(
+        vec(fminf(a.x, b.x), fminf(a.y, b.y)),
+        vec(fmaxf(a.x + a.w, b.x + b.w), fmaxf(a.y + a.h, b.y + b.h)));
+}
+
+static int compare_items_x(const void *a, const void *b)
+{
+    const float x1 = rect_center(((const Item*) a)->rect).x;
+    const float x2 = rect_center(((const Item*) b)->rect).x;
+    return (x1 > x2) - (x1 < x2);
+}
+
+static int compare_items_y(const void *a, const void *b)
+{
+    const float y1 = rect_center(((const Item*) a)->rect).y;
+    const float y2 = rect_center(((const Item*) b)->rect).y;
+    return (y1 > y2) - (y1 < y2);
+}
+
+static void aabb_tree_build(AabbTree *aabb_tree,
+                            size_t node,
+                            size_t first,
+                            size_t count)
+{
+    trace_assert(aabb_tree);
+    trace_assert(count > 0);
+
+    Rect box = aabb_tree->items[first].rect;
+    for (size_t i = first + 1; i < first + count; ++i) {
+        box = rects_union(box, aabb_tree->items[i].rect);
+    }
+    aabb_tree->nodes[node].box = box;
+
+    if (count <= AABB_TREE_LEAF_SIZE) {
+        aabb_tree->nodes[node].first = first;
+        aabb_tree->nodes[node].count = count;
+        return;
+    }
+
+    qsort(aabb_tree->items + first, count, sizeof(Item),
+          box.w > box.h ? compare_items_x : compare_items_y);
+
+    const size_t children = aabb_tree->nodes_count;
+    aabb_tree->nodes_count += 2;
+    aabb_tree->nodes[node].first = children;
+    aabb_tree->nodes[node].count = 0;
+
+    aabb_tree_build(aabb_tree, children, first, count / 2);
+    aabb_tree_build(aabb_tree, children + 1, first + count / 2, count - count / 2);
+}
+
+AabbTree *create_aabb_tree(const Rect *rects, size_t count)
+{
+    trace_assert(rects || count == 0);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    AabbTree *aabb_tree = PUSH_LT(lt, nth_calloc(1, sizeof(AabbTree)), free);
+    if (aabb_tree == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    aabb_tree->lt = lt;
+
+    aabb_tree->items_count = count;
+    aabb_tree->items = PUSH_LT(lt, nth_calloc(count + 1, sizeof(Item)), free);
+    if (aabb_tree->items == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        aabb_tree->items[i].rect = rects[i];
+        aabb_tree->items[i].index = i;
+    }
+
+    // A binary tree with at least one item per leaf has less than
+    // 2 * count nodes
+    aabb_tree->nodes = PUSH_LT(lt, nth_calloc(2 * count + 1, sizeof(Node)), free);
+    if (aabb_tree->nodes == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    if (count > 0) {
+        aabb_tree->nodes_count = 1;
+        aabb_tree_build(aabb_tree, 0, 0, count);
+    }
+
+    return aabb_tree;
+}
+
+void destroy_aabb_tree(AabbTree *aabb_tree)
+{
+    trace_assert(aabb_tree);
+    RETURN_LT0(aabb_tree->lt);
+}
+
+void aabb_tree_refit(AabbTree *aabb_tree, const Rect *rects, size_t count)
+{
+    trace_assert(aabb_tree);
+    trace_assert(rects || count == 0);
+    trace_assert(count == aabb_tree->items_count);
+
+    for (size_t i = 0; i < aabb_tree->items_count; ++i) {
+        aabb_tree->items[i].rect = rects[aabb_tree->items[i].index];
+    }
+
+    // The children are always built after their parent, so walking
+    // the nodes backwards visits the children first
+    for (size_t i = aabb_tree->nodes_count; i-- > 0;) {
+        Node *node = &aabb_tree->nodes[i];
+
+        if (node->count > 0) {
+            Rect box = aabb_tree->items[node->first].rect;
+            for (size_t j = node->first + 1; j < node->first + node->count; ++j) {
+                box = rects_union(box, aabb_tree->items[j].rect);
+            }
+            node->box = box;
+        } else {
+            node->box = rects_union(
+                aabb_tree->nodes[node->first].box,
+                aabb_tree->nodes[node->first + 1].box);
+        }
+    }
+}
+
+int aabb_tree_query(const AabbTree *aabb_tree,
+                    Rect area,
+                    AabbTreeVisit visit,
+                    void *param)
+{
+    trace_assert(aabb_tree);
+    trace_assert(visit);
+
+    if (aabb_tree->nodes_count == 0) {
+        return 0;
+    }
+
+    size_t stack[AABB_TREE_MAX_DEPTH];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node *node = &aabb_tree->nodes[stack[--stack_size]];
+
+        if (!rects_overlap(node->box, area)) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (size_t i = node->first; i < node->first + node->count; ++i) {
+                if (rects_overlap(aabb_tree->items[i].rect, area) &&
+                    visit(param, aabb_tree->items[i].index) < 0) {
+                    return -1;
+                }
+            }
+        } else {
+            trace_assert(stack_size + 2 <= AABB_TREE_MAX_DEPTH);
+            stack[stack_size++] = node->first + 1;
+            stack[stack_size++] = node->first;
+        }
+    }
+
+    return 0;
+}
+
+// Clips [*entry, *exit] to the part of the segment within [min, max]
+// along one axis
+static bool aabb_tree_clip_axis(float begin, float direction,
+                                float min, float max,
+                                float *entry, float *exit)
+{
+    if (direction == 0.0f) {
+        return min <= begin && begin <= max;
+    }
+
+    const float t1 = (min - begin) / direction;
+    const float t2 = (max - begin) / direction;
+
+    *entry = fmaxf(*entry, fminf(t1, t2));
+    *exit = fminf(*exit, fmaxf(t1, t2));
+
+    return *entry <= *exit;
+}
+
+// The fraction of the segment at which it enters the box or INFINITY
+// if it misses the box
+static float aabb_tree_segment_entry(Vec begin, Vec direction, Rect box)
+{
+    float entry = 0.0f;
+    float exit = 1.0f;
+
+    if (!aabb_tree_clip_axis(begin.x, direction.x, box.x, box.x + box.w, &entry, &exit) ||
+        !aabb_tree_clip_axis(begin.y, direction.y, box.y, box.y + box.h, &entry, &exit)) {
+        return INFINITY;
+    }
+
+    return entry;
+}
+
+bool aabb_tree_raycast(const AabbTree *aabb_tree,
+                       Vec begin, Vec end,
+                       AabbTreeFilter filter,
+                       void *param,
+                       size_t *index,
+                       float *t)
+{
+    trace_assert(aabb_tree);
+    trace_assert(index);
+    trace_assert(t);
+
+    if (aabb_tree->nodes_count == 0) {
+        return false;
+    }
+
+    const Vec direction = vec_sub(end, begin);
+    float best = INFINITY;
+
+    size_t stack[AABB_TREE_MAX_DEPTH];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node *node = &aabb_tree->nodes[stack[--stack_size]];
+
+        if (aabb_tree_segment_entry(begin, direction, node->box) >= best) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (size_t i = node->first; i < node->first + node->count; ++i) {
+                const Item *item = &aabb_tree->items[i];
+                const float entry = aabb_tree_segment_entry(begin, direction, item->rect);
+
+                if (entry < best &&
+                    !rect_contains_point(item->rect, begin) &&
+                    (filter == NULL || filter(param, item->index))) {
+                    best = entry;
+                    *index = item->index;
+                }
+            }
+        } else {
+            trace_assert(stack_size + 2 <= AABB_TREE_MAX_DEPTH);
+            stack[stack_size++] = node->first + 1;
+            stack[stack_size++] = node->first;
+        }
+    }
+
+    if (best > 1.0f) {
+        return false;
+    }
+
+    *t = best;
+    return true;
+}
+
+static float aabb_tree_sqr_distance(Vec point, Rect rect)
+{
+    const float dx = fmaxf(fmaxf(rect.x - point.x, 0.0f), point.x - (rect.x + rect.w));
+    const float dy = fmaxf(fmaxf(rect.y - point.y, 0.0f), point.y - (rect.y + rect.h));
+    return dx * dx + dy * dy;
+}
+
+bool aabb_tree_nearest(const AabbTree *aabb_tree,
+                       Vec point,
+                       AabbTreeFilter filter,
+                       void *param,
+                       size_t *index)
+{
+    trace_assert(aabb_tree);
+    trace_assert(index);
+
+    if (aabb_tree->nodes_count == 0) {
+        return false;
+    }
+
+    float best = INFINITY;
+
+    size_t stack[AABB_TREE_MAX_DEPTH];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Node *node = &aabb_tree->nodes[stack[--stack_size]];
+
+        if (aabb_tree_sqr_distance(point, node->box) >= best) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (size_t i = node->first; i < node->first + node->count; ++i) {
+                const Item *item = &aabb_tree->items[i];
+                const float distance = aabb_tree_sqr_distance(point, item->rect);
+
+                if (distance < best &&
+                    (filter == NULL || filter(param, item->index))) {
+                    best = distance;
+                    *index = item->index;
+                }
+            }
+        } else {
+            trace_assert(stack_size + 2 <= AABB_TREE_MAX_DEPTH);
+
+            // The closer child goes on top of the stack to shrink
+            // best as early as possible
+            const size_t closer = node->first;
+            const size_t further = node->first + 1;
+            if (aabb_tree_sqr_distance(point, aabb_tree->nodes[closer].box) <=
+                aabb_tree_sqr_distance(point, aabb_tree->nodes[further].box)) {
+                stack[stack_size++] = further;
+                stack[stack_size++] = closer;
+            } else {
+                stack[stack_size++] = closer;
+                stack[stack_size++] = further;
+            }
+        }
+    }
+
+    return best < INFINITY;
+}
@@ -0,0 +1,66 @@
+#ifndef AABB_TREE_H_
+#define AABB_TREE_H_
+
+#include <stdbool.h>
+
+#include "math/rect.h"
+
+typedef struct AabbTree AabbTree;
+
+/** \brief Callback of aabb_tree_query. Negative result stops the query.
+ */
+typedef int (*AabbTreeVisit)(void *param, size_t index);
+
+/** \brief Filter of aabb_tree_raycast and aabb_tree_nearest. The
+ * rects it returns false for are skipped.
+ */
+typedef bool (*AabbTreeFilter)(void *param, size_t index);
+
+/** \brief Builds a static bounding volume hierarchy over a copy of the rects.
+ */
+AabbTree *create_aabb_tree(const Rect *rects, size_t count);
+void destroy_aabb_tree(AabbTree *aabb_tree);
+
+/** \brief Moves the rects of the tree to the new places without
+ * rebuilding it.
+ *
+ * rects must have as many rects as the tree was built over. The
+ * boxes of the nodes are recomputed in one pass, but the tree gets
+ * looser the further the rects move from where it was built.
+ */
+void aabb_tree_refit(AabbTree *aabb_tree, const Rect *rects, size_t count);
+
+/** \brief Calls visit with the index of every rect that overlaps the area.
+ *
+ * Returns -1 if visit returned a negative value, otherwise 0.
+ */
+int aabb_tree_query(const AabbTree *aabb_tree,
+                    Rect area,
+                    AabbTreeVisit visit,
+                    void *param);
+
+/** \brief Finds the first rect hit by the segment from begin to end.
+ *
+ * The rects that contain begin are not hit. On a hit the index of
+ * the rect and the fraction t of the segment before the hit are
+ * stored. filter may be NULL.
+ */
+bool aabb_tree_raycast(const AabbTree *aabb_tree,
+                       Vec begin, Vec end,
+                       AabbTreeFilter filter,
+                       void *param,
+                       size_t *index,
+                       float *t);
+
+/** \brief Finds the rect closest to the point.
+ *
+ * A rect that contains the point is at the distance 0 and is found
+ * first. filter may be NULL.
+ */
+bool aabb_tree_nearest(const AabbTree *aabb_tree,
+                       Vec point,
+                       AabbTreeFilter filter,
+                       void *param,
+                       size_t *index);
+
+#endif  // AABB_TREE_H_
@@ -98,6 +98,19 @@ int dynarray_push(Dynarray *dynarray, const void *element)
     return 0;
 }
 
+void dynarray_delete_at(Dynarray *dynarray, size_t index)
+{
+    trace_assert(dynarray);
+    trace_assert(index < dynarray->count);
+
+    memmove(
+        (char*) dynarray->data + index * dynarray->element_size,
+        (char*) dynarray->data + (index + 1) * dynarray->element_size,
+        (dynarray->count - index - 1) * dynarray->element_size);
+
+    dynarray->count--;
+}
+
 bool dynarray_contains(const Dynarray *dynarray,
                        const void *element)
 {
@@ -12,6 +12,7 @@ size_t dynarray_count(const Dynarray *dynarray);
 void *dynarray_data(Dynarray *dynarray);
 void dynarray_clear(Dynarray *dynarray);
 int dynarray_push(Dynarray *dynarray, const void *element);
+void dynarray_delete_at(Dynarray *dynarray, size_t index);
 bool dynarray_contains(const Dynarray *dynarray,
                        const void *element);
 
@@ -125,20 +125,33 @@ void destroy_game(Game *game)
     RETURN_LT0(game->lt);
 }
 
-int game_render(const Game *game)
+int game_render(const Game *game, float alpha)
 {
     trace_assert(game);
 
+    // Nothing is updated during the pause, so there is nothing to
+    // interpolate between
+    if (game->state == GAME_STATE_PAUSE) {
+        alpha = 1.0f;
+    }
+
+    camera_interpolate(game->camera, alpha);
+    camera_begin_frame(game->camera);
+
     switch(game->state) {
     case GAME_STATE_RUNNING:
     case GAME_STATE_PAUSE: {
-        if (level_render(game->level, game->camera) < 0) {
+        if (level_render(game->level, game->camera, alpha) < 0) {
             return -1;
         }
     } break;
 
     case GAME_STATE_CONSOLE: {
-        if (level_render(game->level, game->camera) < 0) {
+        if (level_render(game->level, game->camera, alpha) < 0) {
+            return -1;
+        }
+
+        if (camera_flush(game->camera) < 0) {
             return -1;
         }
 
@@ -156,7 +169,7 @@ int game_render(const Game *game)
     case GAME_STATE_QUIT: break;
     }
 
-    return 0;
+    return camera_flush(game->camera);
 }
 
 int game_sound(Game *game)
@@ -387,6 +400,13 @@ int game_event(Game *game, const SDL_Event *event)
     trace_assert(game);
     trace_assert(event);
 
+    // The textures the platforms were baked into are lost
+    if ((event->type == SDL_RENDER_TARGETS_RESET ||
+         event->type == SDL_RENDER_DEVICE_RESET) &&
+        game->level != NULL) {
+        level_drop_tiles(game->level);
+    }
+
     switch (game->state) {
     case GAME_STATE_RUNNING:
         return game_event_running(game, event);
@@ -452,6 +472,10 @@ game_send(Game *game, Gc *gc, struct Scope *scope,
 
     if (strcmp(target, "level") == 0) {
         return level_send(game->level, gc, scope, rest);
+    } else if (strcmp(target, "render-stats") == 0) {
+        const CameraStats stats = camera_stats(game->camera);
+        return eval_success(
+            list(gc, "dd", (long int) stats.drawn, (long int) stats.culled));
     } else if (strcmp(target, "menu") == 0) {
         level_picker_clean_selection(game->level_picker);
         game->state = GAME_STATE_LEVEL_PICKER;
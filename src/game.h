@@ -14,7 +14,9 @@ Game *create_game(const char *platforms_file_path,
                     SDL_Renderer *renderer);
 void destroy_game(Game *game);
 
-int game_render(const Game *game);
+/** \brief Renders the game alpha of the way between the last two updates.
+ */
+int game_render(const Game *game, float alpha);
 int game_sound(Game *game);
 int game_update(Game *game, float delta_time);
 
@@ -4,7 +4,10 @@
 #include <stdbool.h>
 
 #include "camera.h"
+#include "debug_overlay.h"
+#include "dynarray.h"
 #include "sdl/renderer.h"
+#include "system/lt.h"
 #include "system/nth_alloc.h"
 #include "system/log.h"
 
@@ -12,24 +15,64 @@
 #define RATIO_Y 9.0f
 
 struct Camera {
+    Lt *lt;
     bool debug_mode;
     bool blackwhite_mode;
+    // position is where the camera is rendered from. It goes from
+    // previous_position to next_position during a physics step.
     Point position;
+    Point previous_position;
+    Point next_position;
     float scale;
     SDL_Renderer *renderer;
     Sprite_font *font;
+
+    // The area of the world on the screen in the current frame. The
+    // objects outside of it are culled before they are drawn.
+    Rect visible_area;
+    CameraStats stats;
+
+    // The filled rects of the same color that were drawn in a row.
+    // They are submitted with one SDL_RenderFillRects when the color
+    // changes or anything else is drawn, so the order of the drawing
+    // stays the same.
+    Dynarray *batch;
+    SDL_Color batch_color;
+
+    // The filled triangles that were drawn in a row in the screen
+    // coordinates. Every triangle keeps its own color, so they are
+    // all submitted together with fill_triangles.
+    Dynarray *triangles;
+    Dynarray *triangle_colors;
+
+    // The transform of the frame. A point p of the world is at
+    // p * transform_scale + transform_offset on the screen. It is
+    // updated when the camera moves and the view port is queried
+    // once per frame.
+    SDL_Rect view_port;
+    Vec transform_scale;
+    Vec transform_offset;
+
+    // The debug texts of the current frame
+    Debug_overlay *debug_overlay;
+
+    // Scratch space of camera_fill_rects
+    size_t rects_capacity;
+    SDL_Rect *rects;
 };
 
 static Vec effective_ratio(const SDL_Rect *view_port);
 static Vec effective_scale(const SDL_Rect *view_port);
+static void camera_update_transform(Camera *camera);
 static Vec camera_point(const Camera *camera,
-                        const SDL_Rect *view_port,
                         const Vec p);
 static Rect camera_rect(const Camera *camera,
-                        const SDL_Rect *view_port,
-                        const Rect rect);
+                        const Rect r);
+static void camera_transform_rects(const Camera *camera,
+                                   const Rect *rects,
+                                   SDL_Rect *result,
+                                   size_t count);
 static Triangle camera_triangle(const Camera *camera,
-                                  const SDL_Rect *view_port,
                                   const Triangle t);
 
 Camera *create_camera(SDL_Renderer *renderer,
@@ -38,27 +81,150 @@ Camera *create_camera(SDL_Renderer *renderer,
     trace_assert(renderer);
     trace_assert(font);
 
-    Camera *camera = nth_alloc(sizeof(Camera));
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
 
+    Camera *camera = PUSH_LT(lt, nth_alloc(sizeof(Camera)), free);
     if (camera == NULL) {
-        return NULL;
+        RETURN_LT(lt, NULL);
+    }
+    camera->lt = lt;
+
+    camera->batch = PUSH_LT(lt, create_dynarray(sizeof(SDL_Rect)), destroy_dynarray);
+    if (camera->batch == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    camera->batch_color = (SDL_Color) { 0, 0, 0, 0 };
+
+    camera->debug_overlay = PUSH_LT(lt, create_debug_overlay(), destroy_debug_overlay);
+    if (camera->debug_overlay == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    camera->triangles = PUSH_LT(lt, create_dynarray(sizeof(Triangle)), destroy_dynarray);
+    if (camera->triangles == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    camera->triangle_colors = PUSH_LT(lt, create_dynarray(sizeof(SDL_Color)), destroy_dynarray);
+    if (camera->triangle_colors == NULL) {
+        RETURN_LT(lt, NULL);
     }
 
     camera->position = vec(0.0f, 0.0f);
+    camera->previous_position = vec(0.0f, 0.0f);
+    camera->next_position = vec(0.0f, 0.0f);
     camera->scale = 1.0f;
     camera->debug_mode = 0;
     camera->blackwhite_mode = 0;
     camera->renderer = renderer;
     camera->font = font;
+    camera->visible_area = rect(0.0f, 0.0f, 0.0f, 0.0f);
+    camera->stats.drawn = 0;
+    camera->stats.culled = 0;
+    camera->rects_capacity = 0;
+    camera->rects = NULL;
+
+    SDL_RenderGetViewport(camera->renderer, &camera->view_port);
+    camera_update_transform(camera);
 
     return camera;
 }
 
 void destroy_camera(Camera *camera)
+{
+    trace_assert(camera);
+    RETURN_LT0(camera->lt);
+}
+
+static int camera_flush_triangles(Camera *camera)
+{
+    trace_assert(camera);
+
+    const size_t count = dynarray_count(camera->triangles);
+    if (count == 0) {
+        return 0;
+    }
+
+    if (fill_triangles(
+            camera->renderer,
+            dynarray_data(camera->triangles),
+            dynarray_data(camera->triangle_colors),
+            count) < 0) {
+        return -1;
+    }
+
+    dynarray_clear(camera->triangles);
+    dynarray_clear(camera->triangle_colors);
+
+    return 0;
+}
+
+static int camera_flush_rects(Camera *camera)
+{
+    trace_assert(camera);
+
+    const size_t count = dynarray_count(camera->batch);
+    if (count == 0) {
+        return 0;
+    }
+
+    const SDL_Color c = camera->batch_color;
+    if (SDL_SetRenderDrawColor(camera->renderer, c.r, c.g, c.b, c.a) < 0) {
+        log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (SDL_RenderFillRects(camera->renderer, dynarray_data(camera->batch), (int) count) < 0) {
+        log_fail("SDL_RenderFillRects: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    dynarray_clear(camera->batch);
+
+    return 0;
+}
+
+int camera_flush(Camera *camera)
 {
     trace_assert(camera);
 
-    free(camera);
+    // Only one of the batches is non-empty at a time
+    if (camera_flush_triangles(camera) < 0) {
+        return -1;
+    }
+
+    return camera_flush_rects(camera);
+}
+
+static int camera_batch_rect(Camera *camera,
+                             SDL_Rect sdl_rect,
+                             Color color)
+{
+    trace_assert(camera);
+
+    if (camera_flush_triangles(camera) < 0) {
+        return -1;
+    }
+
+    SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
+    if (camera->debug_mode) {
+        sdl_color.a = sdl_color.a / 2;
+    }
+
+    if (sdl_color.r != camera->batch_color.r ||
+        sdl_color.g != camera->batch_color.g ||
+        sdl_color.b != camera->batch_color.b ||
+        sdl_color.a != camera->batch_color.a) {
+        if (camera_flush_rects(camera) < 0) {
+            return -1;
+        }
+        camera->batch_color = sdl_color;
+    }
+
+    return dynarray_push(camera->batch, &sdl_rect);
 }
 
 int camera_fill_rect(Camera *camera,
@@ -67,28 +233,185 @@ int camera_fill_rect(Camera *camera,
 {
     trace_assert(camera);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
+    return camera_batch_rect(
+        camera,
+        rect_for_sdl(camera_rect(camera, rect)),
+        color);
+}
 
-    const SDL_Rect sdl_rect = rect_for_sdl(
-        camera_rect(camera, &view_port, rect));
+int camera_fill_rects(Camera *camera,
+                      const Rect *rects,
+                      const Color *colors,
+                      size_t count)
+{
+    trace_assert(camera);
+    trace_assert(rects || count == 0);
+    trace_assert(colors || count == 0);
 
-    const SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
+    if (count > camera->rects_capacity) {
+        SDL_Rect *new_rects = nth_realloc(camera->rects, sizeof(SDL_Rect) * count);
+        if (new_rects == NULL) {
+            return -1;
+        }
 
-    if (camera->debug_mode) {
-        if (SDL_SetRenderDrawColor(camera->renderer, sdl_color.r, sdl_color.g, sdl_color.b, sdl_color.a / 2) < 0) {
-            log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
+        if (camera->rects == NULL) {
+            camera->rects = PUSH_LT(camera->lt, new_rects, free);
+        } else {
+            camera->rects = REPLACE_LT(camera->lt, camera->rects, new_rects);
+        }
+        camera->rects_capacity = count;
+    }
+
+    camera_transform_rects(camera, rects, camera->rects, count);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (camera_batch_rect(camera, camera->rects[i], colors[i]) < 0) {
             return -1;
         }
-    } else {
+    }
+
+    return 0;
+}
+
+static int camera_draw_baked_rects(Camera *camera,
+                                   Rect area,
+                                   const Rect *rects,
+                                   const Color *colors,
+                                   size_t count)
+{
+    trace_assert(camera);
+
+    if (SDL_SetRenderDrawBlendMode(camera->renderer, SDL_BLENDMODE_NONE) < 0) {
+        log_fail("SDL_SetRenderDrawBlendMode: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (SDL_SetRenderDrawColor(camera->renderer, 0, 0, 0, 0) < 0) {
+        log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (SDL_RenderClear(camera->renderer) < 0) {
+        log_fail("SDL_RenderClear: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    const Vec k = camera->transform_scale;
+
+    for (size_t i = 0; i < count; ++i) {
+        const SDL_Color sdl_color = color_for_sdl(
+            camera->blackwhite_mode ? color_desaturate(colors[i]) : colors[i]);
         if (SDL_SetRenderDrawColor(camera->renderer, sdl_color.r, sdl_color.g, sdl_color.b, sdl_color.a) < 0) {
             log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
             return -1;
         }
+
+        const SDL_Rect sdl_rect = rect_for_sdl(
+            rect((rects[i].x - area.x) * k.x,
+                 (rects[i].y - area.y) * k.y,
+                 rects[i].w * k.x,
+                 rects[i].h * k.y));
+        if (SDL_RenderFillRect(camera->renderer, &sdl_rect) < 0) {
+            log_fail("SDL_RenderFillRect: %s\n", SDL_GetError());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int camera_can_bake(const Camera *camera)
+{
+    trace_assert(camera);
+    // The debug mode draws everything half transparent, which does
+    // not survive the baking
+    return !camera->debug_mode && SDL_RenderTargetSupported(camera->renderer);
+}
+
+SDL_Texture *camera_bake_rects(Camera *camera,
+                               Rect area,
+                               int width, int height,
+                               const Rect *rects,
+                               const Color *colors,
+                               size_t count)
+{
+    trace_assert(camera);
+    trace_assert(rects || count == 0);
+    trace_assert(colors || count == 0);
+
+    if (camera_flush(camera) < 0) {
+        return NULL;
+    }
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
     }
 
-    if (SDL_RenderFillRect(camera->renderer, &sdl_rect) < 0) {
-        log_fail("SDL_RenderFillRect: %s\n", SDL_GetError());
+    SDL_Texture *texture = PUSH_LT(
+        lt,
+        SDL_CreateTexture(
+            camera->renderer,
+            SDL_PIXELFORMAT_RGBA8888,
+            SDL_TEXTUREACCESS_TARGET,
+            width, height),
+        SDL_DestroyTexture);
+    if (texture == NULL) {
+        log_fail("SDL_CreateTexture: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    if (SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND) < 0) {
+        log_fail("SDL_SetTextureBlendMode: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    SDL_Texture *const target = SDL_GetRenderTarget(camera->renderer);
+    SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+    if (SDL_GetRenderDrawBlendMode(camera->renderer, &blend_mode) < 0) {
+        log_fail("SDL_GetRenderDrawBlendMode: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    if (SDL_SetRenderTarget(camera->renderer, texture) < 0) {
+        log_fail("SDL_SetRenderTarget: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    const int result = camera_draw_baked_rects(camera, area, rects, colors, count);
+
+    if (SDL_SetRenderTarget(camera->renderer, target) < 0) {
+        log_fail("SDL_SetRenderTarget: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    if (SDL_SetRenderDrawBlendMode(camera->renderer, blend_mode) < 0) {
+        log_fail("SDL_SetRenderDrawBlendMode: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    if (result < 0) {
+        RETURN_LT(lt, NULL);
+    }
+
+    RELEASE_LT(lt, texture);
+    RETURN_LT(lt, texture);
+}
+
+int camera_blit(Camera *camera,
+                SDL_Texture *texture,
+                Rect area)
+{
+    trace_assert(camera);
+    trace_assert(texture);
+
+    if (camera_flush(camera) < 0) {
+        return -1;
+    }
+
+    const SDL_Rect sdl_rect = rect_for_sdl(camera_rect(camera, area));
+    if (SDL_RenderCopy(camera->renderer, texture, NULL, &sdl_rect) < 0) {
+        log_fail("SDL_RenderCopy: %s\n", SDL_GetError());
         return -1;
     }
 
@@ -101,11 +424,11 @@ int camera_draw_rect(Camera * camera,
 {
     trace_assert(camera);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
+    if (camera_flush(camera) < 0) {
+        return -1;
+    }
 
-    const SDL_Rect sdl_rect = rect_for_sdl(
-        camera_rect(camera, &view_port, rect));
+    const SDL_Rect sdl_rect = rect_for_sdl(camera_rect(camera, rect));
 
     const SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
 
@@ -128,8 +451,9 @@ int camera_draw_triangle(Camera *camera,
 {
     trace_assert(camera);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
+    if (camera_flush(camera) < 0) {
+        return -1;
+    }
 
     const SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
 
@@ -138,7 +462,7 @@ int camera_draw_triangle(Camera *camera,
         return -1;
     }
 
-    if (draw_triangle(camera->renderer, camera_triangle(camera, &view_port, t)) < 0) {
+    if (draw_triangle(camera->renderer, camera_triangle(camera, t)) < 0) {
         return -1;
     }
 
@@ -151,29 +475,21 @@ int camera_fill_triangle(Camera *camera,
 {
     trace_assert(camera);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
-
-    const SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
-
+    if (camera_flush_rects(camera) < 0) {
+        return -1;
+    }
 
+    SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
     if (camera->debug_mode) {
-        if (SDL_SetRenderDrawColor(camera->renderer, sdl_color.r, sdl_color.g, sdl_color.b, sdl_color.a / 2) < 0) {
-            log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
-            return -1;
-        }
-    } else {
-        if (SDL_SetRenderDrawColor(camera->renderer, sdl_color.r, sdl_color.g, sdl_color.b, sdl_color.a) < 0) {
-            log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
-            return -1;
-        }
+        sdl_color.a = sdl_color.a / 2;
     }
 
-    if (fill_triangle(camera->renderer, camera_triangle(camera, &view_port, t)) < 0) {
+    const Triangle screen_triangle = camera_triangle(camera, t);
+    if (dynarray_push(camera->triangles, &screen_triangle) < 0) {
         return -1;
     }
 
-    return 0;
+    return dynarray_push(camera->triangle_colors, &sdl_color);
 }
 
 int camera_render_text(Camera *camera,
@@ -182,17 +498,26 @@ int camera_render_text(Camera *camera,
                        Color c,
                        Vec position)
 {
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
+    trace_assert(camera);
+    trace_assert(text);
+
+    if (!camera_is_rect_visible(
+            camera,
+            sprite_font_boundary_box(camera->font, position, size, text))) {
+        return 0;
+    }
 
-    const Vec scale = effective_scale(&view_port);
-    const Vec screen_position = camera_point(camera, &view_port, position);
+    if (camera_flush(camera) < 0) {
+        return -1;
+    }
+
+    const Vec screen_position = camera_point(camera, position);
 
     if (sprite_font_render_text(
             camera->font,
             camera->renderer,
             screen_position,
-            vec(size.x * scale.x * camera->scale, size.y * scale.y * camera->scale),
+            vec_entry_mult(size, camera->transform_scale),
             camera->blackwhite_mode ? color_desaturate(c) : c,
             text) < 0) {
         return -1;
@@ -212,21 +537,101 @@ int camera_render_debug_text(Camera *camera,
         return 0;
     }
 
-    if (camera_render_text(
+    if (!camera_is_rect_visible(
             camera,
-            text,
-            vec(2.0f, 2.0f),
-            rgba(0.0f, 0.0f, 0.0f, 1.0f),
-            position) < 0) {
+            sprite_font_boundary_box(camera->font, position, vec(2.0f, 2.0f), text))) {
+        return 0;
+    }
+
+    return debug_overlay_push(
+        camera->debug_overlay,
+        camera_point(camera, position),
+        text);
+}
+
+/* Tells if a debug text at the position may be on the screen before
+ * it is formatted, assuming it is as long as it can be. The texts
+ * that pass are counted by camera_render_debug_text, so only the
+ * culled ones are counted here. */
+static bool camera_is_debug_text_visible(Camera *camera, Vec position)
+{
+    trace_assert(camera);
+
+    const Rect area = rect(
+        position.x, position.y,
+        2.0f * FONT_CHAR_WIDTH * (float) (DEBUG_OVERLAY_TEXT_SIZE - 1),
+        2.0f * FONT_CHAR_HEIGHT);
+
+    if (!rects_overlap(camera->visible_area, area)) {
+        camera_count_culled(camera, 0, 1);
+        return false;
+    }
+
+    return true;
+}
+
+int camera_render_debug_vec(Camera *camera,
+                            const char *label,
+                            Vec value,
+                            Vec position)
+{
+    trace_assert(camera);
+    trace_assert(label);
+
+    if (!camera->debug_mode || !camera_is_debug_text_visible(camera, position)) {
+        return 0;
+    }
+
+    return camera_render_debug_text(
+        camera,
+        debug_overlay_format_vec(camera->debug_overlay, label, value),
+        position);
+}
+
+int camera_render_debug_long(Camera *camera,
+                             const char *label,
+                             long int value,
+                             Vec position)
+{
+    trace_assert(camera);
+    trace_assert(label);
+
+    if (!camera->debug_mode || !camera_is_debug_text_visible(camera, position)) {
+        return 0;
+    }
+
+    return camera_render_debug_text(
+        camera,
+        debug_overlay_format_long(camera->debug_overlay, label, value),
+        position);
+}
+
+int camera_render_debug_overlay(Camera *camera)
+{
+    trace_assert(camera);
+
+    if (camera_flush(camera) < 0) {
         return -1;
     }
 
-    return 0;
+    return debug_overlay_render(
+        camera->debug_overlay,
+        camera->font,
+        camera->renderer,
+        vec_entry_mult(vec(2.0f, 2.0f), camera->transform_scale),
+        rgba(0.0f, 0.0f, 0.0f, 1.0f));
 }
 
 int camera_clear_background(Camera *camera,
                             Color color)
 {
+    trace_assert(camera);
+
+    // Whatever is batched would be cleared anyway
+    dynarray_clear(camera->batch);
+    dynarray_clear(camera->triangles);
+    dynarray_clear(camera->triangle_colors);
+
     const SDL_Color sdl_color = color_for_sdl(camera->blackwhite_mode ? color_desaturate(color) : color);
 
     if (SDL_SetRenderDrawColor(camera->renderer, sdl_color.r, sdl_color.g, sdl_color.b, sdl_color.a) < 0) {
@@ -245,13 +650,92 @@ int camera_clear_background(Camera *camera,
 void camera_center_at(Camera *camera, Point position)
 {
     trace_assert(camera);
+    camera->previous_position = camera->next_position;
+    camera->next_position = position;
+    camera->position = position;
+    camera_update_transform(camera);
+}
+
+void camera_snap_to(Camera *camera, Point position)
+{
+    trace_assert(camera);
+    camera->previous_position = position;
+    camera->next_position = position;
     camera->position = position;
+    camera_update_transform(camera);
+}
+
+void camera_interpolate(Camera *camera, float alpha)
+{
+    trace_assert(camera);
+    camera->position = vec_sum(
+        camera->previous_position,
+        vec_scala_mult(
+            vec_sub(camera->next_position, camera->previous_position),
+            alpha));
+    camera_update_transform(camera);
+}
+
+void camera_begin_frame(Camera *camera)
+{
+    trace_assert(camera);
+    SDL_RenderGetViewport(camera->renderer, &camera->view_port);
+    camera_update_transform(camera);
+    camera->visible_area = camera_view_port(camera);
+    camera->stats.drawn = 0;
+    camera->stats.culled = 0;
+    debug_overlay_clear(camera->debug_overlay);
+}
+
+int camera_is_rect_visible(Camera *camera, Rect rect)
+{
+    trace_assert(camera);
+
+    if (rects_overlap(camera->visible_area, rect)) {
+        camera->stats.drawn++;
+        return 1;
+    }
+
+    camera->stats.culled++;
+    return 0;
+}
+
+void camera_count_culled(Camera *camera, size_t drawn, size_t culled)
+{
+    trace_assert(camera);
+    camera->stats.drawn += drawn;
+    camera->stats.culled += culled;
+}
+
+Vec camera_pixel_scale(const Camera *camera)
+{
+    trace_assert(camera);
+    return camera->transform_scale;
+}
+
+int camera_is_blackwhite_mode(const Camera *camera)
+{
+    trace_assert(camera);
+    return camera->blackwhite_mode;
+}
+
+Rect camera_visible_area(const Camera *camera)
+{
+    trace_assert(camera);
+    return camera->visible_area;
+}
+
+CameraStats camera_stats(const Camera *camera)
+{
+    trace_assert(camera);
+    return camera->stats;
 }
 
 void camera_scale(Camera *camera, float scale)
 {
     trace_assert(camera);
     camera->scale = fmaxf(0.1f, scale);
+    camera_update_transform(camera);
 }
 
 void camera_toggle_debug_mode(Camera *camera)
@@ -274,24 +758,19 @@ void camera_toggle_blackwhite_mode(Camera *camera)
 
 int camera_is_point_visible(const Camera *camera, Point p)
 {
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
+    trace_assert(camera);
 
     return rect_contains_point(
-        rect_from_sdl(&view_port),
-        camera_point(camera, &view_port, p));
+        rect_from_sdl(&camera->view_port),
+        camera_point(camera, p));
 }
 
 Rect camera_view_port(const Camera *camera)
 {
     trace_assert(camera);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
-
-    const Vec s = effective_scale(&view_port);
-    const float w = (float) view_port.w * s.x;
-    const float h = (float) view_port.h * s.y;
+    const float w = (float) camera->view_port.w / camera->transform_scale.x;
+    const float h = (float) camera->view_port.h / camera->transform_scale.y;
 
     return rect(camera->position.x - w * 0.5f,
                 camera->position.y - h * 0.5f,
@@ -306,19 +785,15 @@ int camera_is_text_visible(const Camera *camera,
     trace_assert(camera);
     trace_assert(text);
 
-    SDL_Rect view_port;
-    SDL_RenderGetViewport(camera->renderer, &view_port);
-
     return rects_overlap(
         camera_rect(
             camera,
-            &view_port,
             sprite_font_boundary_box(
                 camera->font,
                 position,
                 size,
                 text)),
-        rect_from_sdl(&view_port));
+        rect_from_sdl(&camera->view_port));
 }
 
 /* ---------- Private Function ---------- */
@@ -339,44 +814,62 @@ static Vec effective_scale(const SDL_Rect *view_port)
         vec_scala_mult(effective_ratio(view_port), 50.0f));
 }
 
-static Vec camera_point(const Camera *camera,
-                          const SDL_Rect *view_port,
-                          const Vec p)
+static void camera_update_transform(Camera *camera)
+{
+    trace_assert(camera);
 
+    camera->transform_scale = vec_scala_mult(
+        effective_scale(&camera->view_port),
+        camera->scale);
+    camera->transform_offset = vec_sub(
+        vec((float) camera->view_port.w * 0.5f,
+            (float) camera->view_port.h * 0.5f),
+        vec_entry_mult(camera->position, camera->transform_scale));
+}
+
+static Vec camera_point(const Camera *camera,
+                        const Vec p)
 {
     return vec_sum(
-        vec_scala_mult(
-            vec_entry_mult(
-                vec_sum(p, vec_neg(camera->position)),
-                effective_scale(view_port)),
-            camera->scale),
-        vec((float) view_port->w * 0.5f,
-            (float) view_port->h * 0.5f));
+        vec_entry_mult(p, camera->transform_scale),
+        camera->transform_offset);
 }
 
 static Triangle camera_triangle(const Camera *camera,
-                                  const SDL_Rect *view_port,
                                   const Triangle t)
 {
     return triangle(
-        camera_point(camera, view_port, t.p1),
-        camera_point(camera, view_port, t.p2),
-        camera_point(camera, view_port, t.p3));
+        camera_point(camera, t.p1),
+        camera_point(camera, t.p2),
+        camera_point(camera, t.p3));
 }
 
 static Rect camera_rect(const Camera *camera,
-                          const SDL_Rect *view_port,
-                          const Rect rect)
+                        const Rect r)
 {
-    return rect_from_points(
-        camera_point(
-            camera,
-            view_port,
-            vec(rect.x, rect.y)),
-        camera_point(
-            camera,
-            view_port,
-            vec(rect.x + rect.w, rect.y + rect.h)));
+    const Vec k = camera->transform_scale;
+    const Vec o = camera->transform_offset;
+    return rect(r.x * k.x + o.x, r.y * k.y + o.y, r.w * k.x, r.h * k.y);
+}
+
+/* The same as camera_rect for a whole array. The iterations do not
+ * depend on each other, so the compiler can vectorize the loop. */
+static void camera_transform_rects(const Camera *camera,
+                                   const Rect *restrict rects,
+                                   SDL_Rect *restrict result,
+                                   size_t count)
+{
+    const float kx = camera->transform_scale.x;
+    const float ky = camera->transform_scale.y;
+    const float ox = camera->transform_offset.x;
+    const float oy = camera->transform_offset.y;
+
+    for (size_t i = 0; i < count; ++i) {
+        result[i].x = (int) roundf(rects[i].x * kx + ox);
+        result[i].y = (int) roundf(rects[i].y * ky + oy);
+        result[i].w = (int) roundf(rects[i].w * kx);
+        result[i].h = (int) roundf(rects[i].h * ky);
+    }
 }
 
 int camera_render_debug_rect(Camera *camera,
@@ -389,6 +882,10 @@ int camera_render_debug_rect(Camera *camera,
         return 0;
     }
 
+    if (!camera_is_rect_visible(camera, rect)) {
+        return 0;
+    }
+
     if (camera_fill_rect(camera, rect, c) < 0) {
         return -1;
     }
@@ -9,6 +9,13 @@
 
 typedef struct Camera Camera;
 
+/** \brief How many objects were drawn and culled in the current frame.
+ */
+typedef struct CameraStats {
+    size_t drawn;
+    size_t culled;
+} CameraStats;
+
 Camera *create_camera(SDL_Renderer *renderer,
                       Sprite_font *font);
 void destroy_camera(Camera *camera);
@@ -16,10 +23,53 @@ void destroy_camera(Camera *camera);
 int camera_clear_background(Camera *camera,
                             Color color);
 
+/** \brief Fills the rect.
+ *
+ * The rects are batched and drawn by camera_flush.
+ */
 int camera_fill_rect(Camera *camera,
                      Rect rect,
                      Color color);
 
+/** \brief Fills the rects with their colors. The rects are
+ * transformed to the screen in one pass.
+ */
+int camera_fill_rects(Camera *camera,
+                      const Rect *rects,
+                      const Color *colors,
+                      size_t count);
+
+/** \brief Draws the batched rects and triangles.
+ *
+ * Must be called before drawing to the renderer directly and at the
+ * end of the frame.
+ */
+int camera_flush(Camera *camera);
+
+/** \brief Checks if camera_bake_rects can be used in the current mode.
+ */
+int camera_can_bake(const Camera *camera);
+
+/** \brief Renders the rects that are in the area of the world into
+ * a new texture of width x height pixels.
+ *
+ * The area must be width x height pixels big at the current
+ * camera_pixel_scale. The texture must be rebaked when the scale or
+ * the black and white mode change.
+ */
+SDL_Texture *camera_bake_rects(Camera *camera,
+                               Rect area,
+                               int width, int height,
+                               const Rect *rects,
+                               const Color *colors,
+                               size_t count);
+
+/** \brief Draws the texture over the area of the world.
+ */
+int camera_blit(Camera *camera,
+                SDL_Texture *texture,
+                Rect area);
+
 int camera_draw_rect(Camera * camera,
                      Rect rect,
                      Color color);
@@ -28,6 +78,10 @@ int camera_draw_triangle(Camera *camera,
                          Triangle t,
                          Color color);
 
+/** \brief Fills the triangle.
+ *
+ * The triangles are batched and drawn by camera_flush.
+ */
 int camera_fill_triangle(Camera *camera,
                          Triangle t,
                          Color color);
@@ -38,15 +92,54 @@ int camera_render_text(Camera *camera,
                        Color color,
                        Vec position);
 
+/** \brief Queues the text for the debug overlay.
+ *
+ * Does nothing outside of the debug mode. The queued texts are drawn
+ * together by camera_render_debug_overlay.
+ */
 int camera_render_debug_text(Camera *camera,
                              const char *text,
                              Vec position);
 
+/** \brief Queues "<label>(x, y)" for the debug overlay.
+ *
+ * The text is formatted only in the debug mode, only when it may be
+ * on the screen and only when the values change.
+ */
+int camera_render_debug_vec(Camera *camera,
+                            const char *label,
+                            Vec value,
+                            Vec position);
+
+/** \brief Same as camera_render_debug_vec but queues "<label><value>".
+ */
+int camera_render_debug_long(Camera *camera,
+                             const char *label,
+                             long int value,
+                             Vec position);
+
+/** \brief Draws the texts queued for the debug overlay on top of
+ * everything that was drawn so far.
+ */
+int camera_render_debug_overlay(Camera *camera);
+
 int camera_render_debug_rect(Camera *camera,
                              Rect rect,
                              Color color);
 
 void camera_center_at(Camera *camera, Point position);
+
+/** \brief Centers the camera at the position without interpolating
+ * from the previous center, for the jumps like the respawns.
+ */
+void camera_snap_to(Camera *camera, Point position);
+
+/** \brief Moves the camera between its last two centers.
+ *
+ * alpha is the fraction of the physics step that has passed since
+ * the last update.
+ */
+void camera_interpolate(Camera *camera, float alpha);
 void camera_scale(Camera *came, float scale);
 
 void camera_toggle_debug_mode(Camera *camera);
@@ -62,4 +155,30 @@ int camera_is_text_visible(const Camera *camera,
 
 Rect camera_view_port(const Camera *camera);
 
+/** \brief Starts the frame: remembers camera_view_port as the
+ * visible area and resets the stats.
+ *
+ * Must be called after the camera is moved for the frame.
+ */
+void camera_begin_frame(Camera *camera);
+
+/** \brief Checks the rect against the visible area of the frame and
+ * counts it as drawn or culled.
+ *
+ * The renderers call it before doing any work for the object.
+ */
+int camera_is_rect_visible(Camera *camera, Rect rect);
+
+/** \brief Counts the objects culled by the renderers that find the
+ * visible ones on their own.
+ */
+void camera_count_culled(Camera *camera, size_t drawn, size_t culled);
+
+/** \brief How many pixels of the screen a unit of the world takes.
+ */
+Vec camera_pixel_scale(const Camera *camera);
+int camera_is_blackwhite_mode(const Camera *camera);
+Rect camera_visible_area(const Camera *camera);
+CameraStats camera_stats(const Camera *camera);
+
 #endif  // CAMERA_H_
@@ -0,0 +1,196 @@
+#include <SDL2/SDL.h>
+#include "system/stacktrace.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "debug_overlay.h"
+#include "dynarray.h"
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+
+#define DEBUG_OVERLAY_TEXTS_COUNT 1024
+
+/* A formatted text and what it was formatted from */
+typedef struct {
+    const char *label;
+    bool is_long;
+    Vec vec_value;
+    long int long_value;
+    char text[DEBUG_OVERLAY_TEXT_SIZE];
+} Debug_overlay_text;
+
+struct Debug_overlay
+{
+    Lt *lt;
+
+    // The recently formatted texts keyed by the label and the
+    // values. A new text replaces the one in its slot.
+    Debug_overlay_text *texts;
+
+    // The texts pushed in the current frame. They follow each other
+    // in one buffer, each terminated with '\0'.
+    Dynarray *positions;
+    Dynarray *buffer;
+};
+
+Debug_overlay *create_debug_overlay(void)
+{
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    Debug_overlay *debug_overlay = PUSH_LT(lt, nth_alloc(sizeof(Debug_overlay)), free);
+    if (debug_overlay == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    debug_overlay->lt = lt;
+
+    debug_overlay->texts = PUSH_LT(
+        lt,
+        nth_calloc(DEBUG_OVERLAY_TEXTS_COUNT, sizeof(Debug_overlay_text)),
+        free);
+    if (debug_overlay->texts == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    debug_overlay->positions = PUSH_LT(lt, create_dynarray(sizeof(Vec)), destroy_dynarray);
+    if (debug_overlay->positions == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    debug_overlay->buffer = PUSH_LT(lt, create_dynarray(sizeof(char)), destroy_dynarray);
+    if (debug_overlay->buffer == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    return debug_overlay;
+}
+
+void destroy_debug_overlay(Debug_overlay *debug_overlay)
+{
+    trace_assert(debug_overlay);
+    RETURN_LT0(debug_overlay->lt);
+}
+
+static Debug_overlay_text *debug_overlay_slot(Debug_overlay *debug_overlay,
+                                              const char *label,
+                                              const void *value,
+                                              size_t value_size)
+{
+    trace_assert(debug_overlay);
+
+    // FNV-1a of the label pointer and the bytes of the value
+    const uintptr_t address = (uintptr_t) label;
+    uint64_t hash = 14695981039346656037u;
+    for (size_t i = 0; i < sizeof(address); ++i) {
+        hash = (hash ^ ((address >> (i * 8)) & 0xff)) * 1099511628211u;
+    }
+    for (size_t i = 0; i < value_size; ++i) {
+        hash = (hash ^ ((const uint8_t *) value)[i]) * 1099511628211u;
+    }
+
+    return &debug_overlay->texts[hash % DEBUG_OVERLAY_TEXTS_COUNT];
+}
+
+const char *debug_overlay_format_vec(Debug_overlay *debug_overlay,
+                                     const char *label,
+                                     Vec value)
+{
+    trace_assert(debug_overlay);
+    trace_assert(label);
+
+    Debug_overlay_text *text = debug_overlay_slot(debug_overlay, label, &value, sizeof(value));
+    if (text->label != label ||
+        text->is_long ||
+        text->vec_value.x != value.x ||
+        text->vec_value.y != value.y) {
+        text->label = label;
+        text->is_long = false;
+        text->vec_value = value;
+        snprintf(text->text, DEBUG_OVERLAY_TEXT_SIZE, "%s(%.2f, %.2f)",
+                 label, (double) value.x, (double) value.y);
+    }
+
+    return text->text;
+}
+
+const char *debug_overlay_format_long(Debug_overlay *debug_overlay,
+                                      const char *label,
+                                      long int value)
+{
+    trace_assert(debug_overlay);
+    trace_assert(label);
+
+    Debug_overlay_text *text = debug_overlay_slot(debug_overlay, label, &value, sizeof(value));
+    if (text->label != label ||
+        !text->is_long ||
+        text->long_value != value) {
+        text->label = label;
+        text->is_long = true;
+        text->long_value = value;
+        snprintf(text->text, DEBUG_OVERLAY_TEXT_SIZE, "%s%ld", label, value);
+    }
+
+    return text->text;
+}
+
+int debug_overlay_push(Debug_overlay *debug_overlay,
+                       Vec position,
+                       const char *text)
+{
+    trace_assert(debug_overlay);
+    trace_assert(text);
+
+    if (dynarray_push(debug_overlay->positions, &position) < 0) {
+        return -1;
+    }
+
+    do {
+        if (dynarray_push(debug_overlay->buffer, text) < 0) {
+            return -1;
+        }
+    } while (*text++ != '\0');
+
+    return 0;
+}
+
+int debug_overlay_render(Debug_overlay *debug_overlay,
+                         const Sprite_font *font,
+                         SDL_Renderer *renderer,
+                         Vec size,
+                         Color color)
+{
+    trace_assert(debug_overlay);
+    trace_assert(font);
+    trace_assert(renderer);
+
+    const size_t count = dynarray_count(debug_overlay->positions);
+    if (count == 0) {
+        return 0;
+    }
+
+    if (sprite_font_render_texts(
+            font,
+            renderer,
+            dynarray_data(debug_overlay->positions),
+            dynarray_data(debug_overlay->buffer),
+            count,
+            size,
+            color) < 0) {
+        return -1;
+    }
+
+    debug_overlay_clear(debug_overlay);
+
+    return 0;
+}
+
+void debug_overlay_clear(Debug_overlay *debug_overlay)
+{
+    trace_assert(debug_overlay);
+    dynarray_clear(debug_overlay->positions);
+    dynarray_clear(debug_overlay->buffer);
+}
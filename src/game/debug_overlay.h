@@ -0,0 +1,50 @@
+#ifndef DEBUG_OVERLAY_H_
+#define DEBUG_OVERLAY_H_
+
+#include <SDL2/SDL.h>
+
+#include "color.h"
+#include "game/sprite_font.h"
+#include "math/point.h"
+
+// The formatted texts are cut to that many bytes with the '\0'
+#define DEBUG_OVERLAY_TEXT_SIZE 64
+
+typedef struct Debug_overlay Debug_overlay;
+
+Debug_overlay *create_debug_overlay(void);
+void destroy_debug_overlay(Debug_overlay *debug_overlay);
+
+/** \brief Formats the vector as "<label>(x, y)" with two decimals.
+ *
+ * The label is written as is, so it is never a format. The text is
+ * formatted again only when the label or the values change since
+ * the last time. The text is valid until the next format call.
+ */
+const char *debug_overlay_format_vec(Debug_overlay *debug_overlay,
+                                     const char *label,
+                                     Vec value);
+
+/** \brief Formats the integer as "<label><value>".
+ */
+const char *debug_overlay_format_long(Debug_overlay *debug_overlay,
+                                      const char *label,
+                                      long int value);
+
+/** \brief Copies the text to be rendered at the screen position.
+ */
+int debug_overlay_push(Debug_overlay *debug_overlay,
+                       Vec position,
+                       const char *text);
+
+/** \brief Renders all of the pushed texts together and forgets them.
+ */
+int debug_overlay_render(Debug_overlay *debug_overlay,
+                         const Sprite_font *font,
+                         SDL_Renderer *renderer,
+                         Vec size,
+                         Color color);
+
+void debug_overlay_clear(Debug_overlay *debug_overlay);
+
+#endif  // DEBUG_OVERLAY_H_
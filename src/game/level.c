@@ -1,5 +1,6 @@
 #include <SDL2/SDL.h>
 #include "system/stacktrace.h"
+#include <math.h>
 
 #include "broadcast.h"
 #include "color.h"
@@ -13,6 +14,7 @@
 #include "game/level/labels.h"
 #include "game/level/lava.h"
 #include "game/level/platforms.h"
+#include "game/level/platforms_renderer.h"
 #include "game/level/player.h"
 #include "game/level/regions.h"
 #include "game/level/rigid_bodies.h"
@@ -35,12 +37,16 @@ struct Level
     RigidBodies *rigid_bodies;
     Player *player;
     Platforms *platforms;
+    PlatformsRenderer *platforms_renderer;
     Goals *goals;
     Lava *lava;
     Platforms *back_platforms;
+    PlatformsRenderer *back_platforms_renderer;
     Boxes *boxes;
     Labels *labels;
     Regions *regions;
+    // The state of the rigid bodies saved by (level snapshot)
+    void *physics_snapshot;
 
     bool flying_mode;
     Vec flying_camera_position;
@@ -106,6 +112,14 @@ Level *create_level_from_file(const char *file_name, Broadcast *broadcast)
         RETURN_LT(lt, NULL);
     }
 
+    level->platforms_renderer = PUSH_LT(
+        lt,
+        create_platforms_renderer(level->platforms),
+        destroy_platforms_renderer);
+    if (level->platforms_renderer == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
     level->goals = PUSH_LT(
         lt,
         create_goals_from_line_stream(level_stream),
@@ -130,6 +144,14 @@ Level *create_level_from_file(const char *file_name, Broadcast *broadcast)
         RETURN_LT(lt, NULL);
     }
 
+    level->back_platforms_renderer = PUSH_LT(
+        lt,
+        create_platforms_renderer(level->back_platforms),
+        destroy_platforms_renderer);
+    if (level->back_platforms_renderer == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
     level->boxes = PUSH_LT(
         lt,
         create_boxes_from_line_stream(level_stream, level->rigid_bodies, level->player),
@@ -154,6 +176,7 @@ Level *create_level_from_file(const char *file_name, Broadcast *broadcast)
         RETURN_LT(lt, NULL);
     }
 
+    level->physics_snapshot = NULL;
     level->flying_mode = false;
     level->flying_camera_position = vec(0.0f, 0.0f);
     level->flying_camera_scale = 1.0f;
@@ -169,7 +192,7 @@ void destroy_level(Level *level)
     RETURN_LT0(level->lt);
 }
 
-int level_render(const Level *level, Camera *camera)
+int level_render(const Level *level, Camera *camera, float alpha)
 {
     trace_assert(level);
 
@@ -177,15 +200,15 @@ int level_render(const Level *level, Camera *camera)
         return -1;
     }
 
-    if (platforms_render(level->back_platforms, camera) < 0) {
+    if (platforms_renderer_render(level->back_platforms_renderer, camera) < 0) {
         return -1;
     }
 
-    if (player_render(level->player, camera) < 0) {
+    if (player_render(level->player, camera, alpha) < 0) {
         return -1;
     }
 
-    if (boxes_render(level->boxes, camera) < 0) {
+    if (boxes_render(level->boxes, camera, alpha) < 0) {
         return -1;
     }
 
@@ -193,7 +216,7 @@ int level_render(const Level *level, Camera *camera)
         return -1;
     }
 
-    if (platforms_render(level->platforms, camera) < 0) {
+    if (platforms_renderer_render(level->platforms_renderer, camera) < 0) {
         return -1;
     }
 
@@ -209,6 +232,10 @@ int level_render(const Level *level, Camera *camera)
         return -1;
     }
 
+    if (camera_render_debug_overlay(camera) < 0) {
+        return -1;
+    }
+
     return 0;
 }
 
@@ -217,18 +244,21 @@ int level_update(Level *level, float delta_time)
     trace_assert(level);
     trace_assert(delta_time > 0);
 
-    boxes_float_in_lava(level->boxes, level->lava);
+    if (boxes_float_in_lava(level->boxes, level->lava) < 0) {
+        return -1;
+    }
     rigid_bodies_apply_omniforce(level->rigid_bodies, vec(0.0f, LEVEL_GRAVITY));
 
-    boxes_update(level->boxes, delta_time);
+    rigid_bodies_integrate_all(level->rigid_bodies, delta_time);
     player_update(level->player, delta_time);
 
     rigid_bodies_collide(level->rigid_bodies, level->platforms);
 
     player_hide_goals(level->player, level->goals);
     player_die_from_lava(level->player, level->lava);
-    regions_player_enter(level->regions, level->player);
-    regions_player_leave(level->regions, level->player);
+    if (regions_update(level->regions, level->player, level->rigid_bodies) < 0) {
+        return -1;
+    }
 
     goals_update(level->goals, delta_time);
     lava_update(level->lava, delta_time);
@@ -340,7 +370,14 @@ int level_reload_preserve_player(Level *level, Broadcast *broadcast)
     if (platforms == NULL) {
         RETURN_LT(lt, -1);
     }
+    PlatformsRenderer * const platforms_renderer = create_platforms_renderer(platforms);
+    if (platforms_renderer == NULL) {
+        destroy_platforms(platforms);
+        RETURN_LT(lt, -1);
+    }
+    level->platforms_renderer = RESET_LT(level->lt, level->platforms_renderer, platforms_renderer);
     level->platforms = RESET_LT(level->lt, level->platforms, platforms);
+    rigid_bodies_wake_up_all(level->rigid_bodies);
 
     Goals * const goals = create_goals_from_line_stream(level_stream);
     if (goals == NULL) {
@@ -358,6 +395,12 @@ int level_reload_preserve_player(Level *level, Broadcast *broadcast)
     if (back_platforms == NULL) {
         RETURN_LT(lt, -1);
     }
+    PlatformsRenderer * const back_platforms_renderer = create_platforms_renderer(back_platforms);
+    if (back_platforms_renderer == NULL) {
+        destroy_platforms(back_platforms);
+        RETURN_LT(lt, -1);
+    }
+    level->back_platforms_renderer = RESET_LT(level->lt, level->back_platforms_renderer, back_platforms_renderer);
     level->back_platforms = RESET_LT(level->lt, level->back_platforms, back_platforms);
 
     Boxes * const boxes = create_boxes_from_line_stream(level_stream, level->rigid_bodies, level->player);
@@ -399,6 +442,13 @@ void level_toggle_debug_mode(Level *level)
     background_toggle_debug_mode(level->background);
 }
 
+void level_drop_tiles(Level *level)
+{
+    trace_assert(level);
+    platforms_renderer_drop_tiles(level->back_platforms_renderer);
+    platforms_renderer_drop_tiles(level->platforms_renderer);
+}
+
 int level_enter_camera_event(Level *level, Camera *camera)
 {
     if (!level->flying_mode) {
@@ -415,6 +465,106 @@ int level_enter_camera_event(Level *level, Camera *camera)
     return 0;
 }
 
+typedef struct {
+    Gc *gc;
+    struct Expr ids;
+} BodiesList;
+
+static int level_collect_body(void *param, RigidBodyId id)
+{
+    BodiesList *bodies = param;
+    trace_assert(bodies);
+
+    bodies->ids = CONS(bodies->gc, NUMBER(bodies->gc, (long int) id), bodies->ids);
+
+    return 0;
+}
+
+// (raycast x1 y1 x2 y2) is the first of (body id x y), (platform x y)
+// and (lava x y) hit by the segment or nil. Whatever contains
+// (x1 y1) is not hit, so the ray can start inside a body.
+static struct EvalResult level_send_raycast(Level *level, Gc *gc, struct Expr rest)
+{
+    long int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+    struct EvalResult res = match_list(gc, "dddd", rest, &x1, &y1, &x2, &y2);
+    if (res.is_error) {
+        return res;
+    }
+
+    const Vec begin = vec((float) x1, (float) y1);
+    const Vec end = vec((float) x2, (float) y2);
+
+    RigidBodyId body = 0;
+    float body_t = INFINITY;
+    const int body_hit = rigid_bodies_raycast(level->rigid_bodies, begin, end, &body, &body_t);
+    if (body_hit < 0) {
+        return eval_failure(STRING(gc, "Could not raycast the bodies"));
+    }
+    if (!body_hit) {
+        body_t = INFINITY;
+    }
+
+    float platform_t = INFINITY;
+    if (!platforms_raycast(level->platforms, begin, end, &platform_t)) {
+        platform_t = INFINITY;
+    }
+
+    float lava_t = INFINITY;
+    if (!lava_raycast(level->lava, begin, end, &lava_t)) {
+        lava_t = INFINITY;
+    }
+
+    const float t = fminf(body_t, fminf(platform_t, lava_t));
+    if (isinf(t)) {
+        return eval_success(NIL(gc));
+    }
+
+    const Vec hit = vec_sum(begin, vec_scala_mult(vec_sub(end, begin), t));
+    const long int hit_x = (long int) hit.x;
+    const long int hit_y = (long int) hit.y;
+
+    if (t == body_t) {
+        return eval_success(list(gc, "qddd", "body", (long int) body, hit_x, hit_y));
+    } else if (t == platform_t) {
+        return eval_success(list(gc, "qdd", "platform", hit_x, hit_y));
+    }
+
+    return eval_success(list(gc, "qdd", "lava", hit_x, hit_y));
+}
+
+static struct EvalResult level_send_overlap(Level *level, Gc *gc, struct Expr rest)
+{
+    const char *layer = NULL;
+    long int x = 0, y = 0, w = 0, h = 0;
+    struct EvalResult res = match_list(gc, "qdddd", rest, &layer, &x, &y, &w, &h);
+    if (res.is_error) {
+        return res;
+    }
+
+    const Rect area = rect((float) x, (float) y, (float) w, (float) h);
+
+    if (strcmp(layer, "bodies") == 0) {
+        BodiesList bodies = {
+            .gc = gc,
+            .ids = NIL(gc)
+        };
+
+        if (rigid_bodies_query_rect(level->rigid_bodies, area, level_collect_body, &bodies) < 0) {
+            return eval_failure(STRING(gc, "Could not query the bodies"));
+        }
+
+        return eval_success(bodies.ids);
+    } else if (strcmp(layer, "platforms") == 0) {
+        return eval_success(
+            platforms_overlaps_rect(level->platforms, area) ? T(gc) : NIL(gc));
+    } else if (strcmp(layer, "lava") == 0) {
+        return eval_success(
+            lava_overlaps_rect(level->lava, area) ? T(gc) : NIL(gc));
+    }
+
+    return unknown_target(gc, "overlap", layer);
+}
+
 struct EvalResult level_send(Level *level, Gc *gc, struct Scope *scope, struct Expr path)
 {
     trace_assert(level);
@@ -441,7 +591,11 @@ struct EvalResult level_send(Level *level, Gc *gc, struct Scope *scope, struct E
             return res;
         }
 
-        rigid_bodies_apply_force(level->rigid_bodies, (size_t) id, vec((float) x, (float) y));
+        if (id < 0 || !rigid_bodies_is_alive(level->rigid_bodies, (RigidBodyId) id)) {
+            return eval_failure(STRING(gc, "body-push expects an id of a live body"));
+        }
+
+        rigid_bodies_apply_force(level->rigid_bodies, (RigidBodyId) id, vec((float) x, (float) y));
 
         return eval_success(NIL(gc));
     } else if (strcmp(target, "body-add") == 0) {
@@ -459,6 +613,134 @@ struct EvalResult level_send(Level *level, Gc *gc, struct Scope *scope, struct E
                     level->rigid_bodies,
                     rect((float)x, (float)y, (float)w, (float)h),
                     hexstr(color))));
+    } else if (strcmp(target, "broadphase") == 0) {
+        const char *broadphase = NULL;
+        res = match_list(gc, "q", rest, &broadphase);
+        if (res.is_error) {
+            return res;
+        }
+
+        if (strcmp(broadphase, "brute-force") == 0) {
+            rigid_bodies_set_broadphase(level->rigid_bodies, RIGID_BODIES_BROADPHASE_BRUTE_FORCE);
+        } else if (strcmp(broadphase, "grid") == 0) {
+            rigid_bodies_set_broadphase(level->rigid_bodies, RIGID_BODIES_BROADPHASE_GRID);
+        } else if (strcmp(broadphase, "sweep-and-prune") == 0) {
+            rigid_bodies_set_broadphase(level->rigid_bodies, RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE);
+        } else {
+            return unknown_target(gc, "broadphase", broadphase);
+        }
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "solver-iterations") == 0) {
+        long int iterations = 0;
+        res = match_list(gc, "d", rest, &iterations);
+        if (res.is_error) {
+            return res;
+        }
+
+        if (iterations <= 0) {
+            return eval_failure(STRING(gc, "solver-iterations expects a positive number"));
+        }
+
+        rigid_bodies_set_solver_iterations(level->rigid_bodies, (size_t) iterations);
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "threads") == 0) {
+        long int threads = 0;
+        res = match_list(gc, "d", rest, &threads);
+        if (res.is_error) {
+            return res;
+        }
+
+        if (threads <= 0) {
+            return eval_failure(STRING(gc, "threads expects a positive number"));
+        }
+
+        // More threads than cores only adds the switching between them
+        const long int cpus = (long int) SDL_GetCPUCount();
+        if (threads > cpus) {
+            log_info("Clamping the physics threads from %ld to %ld\n", threads, cpus);
+            threads = cpus;
+        }
+
+        if (rigid_bodies_set_threads_count(level->rigid_bodies, (size_t) threads) < 0) {
+            return eval_failure(STRING(gc, "Could not start the physics threads"));
+        }
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "region-watch") == 0) {
+        long int id = 0;
+        res = match_list(gc, "d", rest, &id);
+        if (res.is_error) {
+            return res;
+        }
+
+        if (id < 0 || !rigid_bodies_is_alive(level->rigid_bodies, (RigidBodyId) id)) {
+            return eval_failure(STRING(gc, "region-watch expects an id of a live body"));
+        }
+
+        if (regions_watch_body(level->regions, (RigidBodyId) id) < 0) {
+            return eval_failure(STRING(gc, "Could not watch the body"));
+        }
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "region-unwatch") == 0) {
+        long int id = 0;
+        res = match_list(gc, "d", rest, &id);
+        if (res.is_error) {
+            return res;
+        }
+
+        if (id < 0) {
+            return eval_failure(STRING(gc, "region-unwatch expects an id of a body"));
+        }
+
+        regions_unwatch_body(level->regions, (RigidBodyId) id);
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "snapshot") == 0) {
+        void *snapshot = nth_alloc(rigid_bodies_snapshot_size(level->rigid_bodies));
+        if (snapshot == NULL) {
+            return eval_failure(STRING(gc, "Could not allocate the snapshot"));
+        }
+
+        if (level->physics_snapshot == NULL) {
+            level->physics_snapshot = PUSH_LT(level->lt, snapshot, free);
+        } else {
+            level->physics_snapshot = RESET_LT(level->lt, level->physics_snapshot, snapshot);
+        }
+
+        rigid_bodies_snapshot(level->rigid_bodies, level->physics_snapshot);
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "restore") == 0) {
+        if (level->physics_snapshot == NULL) {
+            return eval_failure(STRING(gc, "There is no snapshot to restore"));
+        }
+
+        if (rigid_bodies_restore(level->rigid_bodies, level->physics_snapshot) < 0) {
+            return eval_failure(STRING(gc, "Could not restore the snapshot"));
+        }
+
+        return eval_success(NIL(gc));
+    } else if (strcmp(target, "raycast") == 0) {
+        return level_send_raycast(level, gc, rest);
+    } else if (strcmp(target, "overlap") == 0) {
+        return level_send_overlap(level, gc, rest);
+    } else if (strcmp(target, "nearest") == 0) {
+        long int x = 0, y = 0;
+        res = match_list(gc, "dd", rest, &x, &y);
+        if (res.is_error) {
+            return res;
+        }
+
+        RigidBodyId id = 0;
+        const int found = rigid_bodies_nearest(level->rigid_bodies, vec((float) x, (float) y), &id);
+        if (found < 0) {
+            return eval_failure(STRING(gc, "Could not query the bodies"));
+        }
+
+        return eval_success(found ? NUMBER(gc, (long int) id) : NIL(gc));
     } else if (strcmp(target, "fly") == 0) {
         level->flying_mode = !level->flying_mode;
         SDL_SetRelativeMouseMode(level->flying_mode);
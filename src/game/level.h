@@ -16,7 +16,9 @@ typedef struct Level Level;
 Level *create_level_from_file(const char *file_name, Broadcast *broadcast);
 void destroy_level(Level *level);
 
-int level_render(const Level *level, Camera *camera);
+/** \brief Renders the level alpha of the way between the last two steps.
+ */
+int level_render(const Level *level, Camera *camera, float alpha);
 
 int level_sound(Level *level, Sound_samples *sound_samples);
 int level_update(Level *level, float delta_time);
@@ -31,6 +33,10 @@ int level_reload_preserve_player(Level *level,
                                  Broadcast *broadcast);
 
 void level_toggle_debug_mode(Level *level);
+/** \brief Drops everything the level baked into the textures of the
+ * renderer.
+ */
+void level_drop_tiles(Level *level);
 void level_toggle_pause_mode(Level *level);
 
 struct EvalResult level_send(Level *level, Gc *gc, struct Scope *scope, struct Expr path);
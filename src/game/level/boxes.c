@@ -1,6 +1,7 @@
 #include "system/stacktrace.h"
 
 #include "broadcast.h"
+#include "dynarray.h"
 #include "ebisp/builtins.h"
 #include "ebisp/interpreter.h"
 #include "game/level/boxes.h"
@@ -12,15 +13,12 @@
 #include "system/lt.h"
 #include "system/nth_alloc.h"
 
-#define BOXES_CAPACITY 1000
-
 struct Boxes
 {
     Lt *lt;
     RigidBodies *rigid_bodies;
-    RigidBodyId *body_ids;
+    Dynarray *body_ids;
     const Player *player;
-    size_t count;
 };
 
 Boxes *create_boxes_from_line_stream(LineStream *line_stream, RigidBodies *rigid_bodies, const Player *player)
@@ -41,24 +39,26 @@ Boxes *create_boxes_from_line_stream(LineStream *line_stream, RigidBodies *rigid
 
     boxes->rigid_bodies = rigid_bodies;
 
+    size_t count = 0;
     if (sscanf(
             line_stream_next(line_stream),
             "%lu",
-            &boxes->count) == EOF) {
+            &count) == EOF) {
         log_fail("Could not read amount of boxes\n");
         RETURN_LT(lt, NULL);
     }
-    log_info("Boxes count: %d\n", boxes->count);
-
-    trace_assert(boxes->count < BOXES_CAPACITY);
+    log_info("Boxes count: %lu\n", count);
 
-    boxes->body_ids = PUSH_LT(lt, nth_alloc(sizeof(RigidBodyId) * BOXES_CAPACITY), free);
+    boxes->body_ids = PUSH_LT(lt, create_dynarray(sizeof(RigidBodyId)), destroy_dynarray);
     if (boxes->body_ids == NULL) {
         RETURN_LT(lt, NULL);
     }
 
-    for (size_t i = 0; i < boxes->count; ++i) {
-        boxes->body_ids[i] = rigid_bodies_add_from_line_stream(boxes->rigid_bodies, line_stream);
+    for (size_t i = 0; i < count; ++i) {
+        const RigidBodyId body_id = rigid_bodies_add_from_line_stream(boxes->rigid_bodies, line_stream);
+        if (dynarray_push(boxes->body_ids, &body_id) < 0) {
+            RETURN_LT(lt, NULL);
+        }
     }
 
     boxes->player = player;
@@ -70,20 +70,24 @@ void destroy_boxes(Boxes *boxes)
 {
     trace_assert(boxes);
 
-    for (size_t i = 0; i < boxes->count; ++i) {
-        rigid_bodies_remove(boxes->rigid_bodies, boxes->body_ids[i]);
+    const size_t count = dynarray_count(boxes->body_ids);
+    RigidBodyId *body_ids = dynarray_data(boxes->body_ids);
+    for (size_t i = 0; i < count; ++i) {
+        rigid_bodies_remove(boxes->rigid_bodies, body_ids[i]);
     }
 
     RETURN_LT0(boxes->lt);
 }
 
-int boxes_render(Boxes *boxes, Camera *camera)
+int boxes_render(Boxes *boxes, Camera *camera, float alpha)
 {
     trace_assert(boxes);
     trace_assert(camera);
 
-    for (size_t i = 0; i < boxes->count; ++i) {
-        if (rigid_bodies_render(boxes->rigid_bodies, boxes->body_ids[i], camera) < 0) {
+    const size_t count = dynarray_count(boxes->body_ids);
+    RigidBodyId *body_ids = dynarray_data(boxes->body_ids);
+    for (size_t i = 0; i < count; ++i) {
+        if (rigid_bodies_render(boxes->rigid_bodies, body_ids[i], camera, alpha) < 0) {
             return -1;
         }
     }
@@ -91,38 +95,28 @@ int boxes_render(Boxes *boxes, Camera *camera)
     return 0;
 }
 
-int boxes_update(Boxes *boxes,
-                 float delta_time)
-{
-    trace_assert(boxes);
-    trace_assert(delta_time);
-
-    for (size_t i = 0; i < boxes->count; ++i) {
-        if (rigid_bodies_update(boxes->rigid_bodies, boxes->body_ids[i], delta_time) < 0) {
-            return -1;
-        }
-    }
-
-    return 0;
-}
-
-void boxes_float_in_lava(Boxes *boxes, Lava *lava)
+int boxes_float_in_lava(Boxes *boxes, Lava *lava)
 {
     trace_assert(boxes);
     trace_assert(lava);
 
-    for (size_t i = 0; i < boxes->count; ++i) {
-        lava_float_rigid_body(lava, boxes->rigid_bodies, boxes->body_ids[i]);
-    }
+    return lava_float_rigid_bodies(
+        lava,
+        boxes->rigid_bodies,
+        dynarray_data(boxes->body_ids),
+        dynarray_count(boxes->body_ids));
 }
 
 static
 int boxes_add_box(Boxes *boxes, Rect rect, Color color)
 {
     trace_assert(boxes);
-    trace_assert(boxes->count < BOXES_CAPACITY);
+    const RigidBodyId body_id = rigid_bodies_add(boxes->rigid_bodies, rect, color);
 
-    boxes->body_ids[boxes->count++] = rigid_bodies_add(boxes->rigid_bodies, rect, color);
+    if (dynarray_push(boxes->body_ids, &body_id) < 0) {
+        rigid_bodies_remove(boxes->rigid_bodies, body_id);
+        return -1;
+    }
 
     return 0;
 }
@@ -159,7 +153,9 @@ boxes_send(Boxes *boxes, Gc *gc, struct Scope *scope, struct Expr path)
                 color = hexstr(color_hex);
             }
 
-            boxes_add_box(boxes, rect((float) x, (float) y, (float) w, (float) h), color);
+            if (boxes_add_box(boxes, rect((float) x, (float) y, (float) w, (float) h), color) < 0) {
+                return eval_failure(STRING(gc, "Could not add the box"));
+            }
 
             return eval_success(NIL(gc));
         } else if (strcmp(action, "new-here") == 0) {
@@ -178,7 +174,9 @@ boxes_send(Boxes *boxes, Gc *gc, struct Scope *scope, struct Expr path)
             }
 
             const Rect hitbox = player_hitbox(boxes->player);
-            boxes_add_box(boxes, rect(hitbox.x, hitbox.y, (float) w, (float) h), color);
+            if (boxes_add_box(boxes, rect(hitbox.x, hitbox.y, (float) w, (float) h), color) < 0) {
+                return eval_failure(STRING(gc, "Could not add the box"));
+            }
 
             return eval_success(NIL(gc));
         }
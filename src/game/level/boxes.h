@@ -15,10 +15,9 @@ typedef struct Player Player;
 Boxes *create_boxes_from_line_stream(LineStream *line_stream, RigidBodies *rigid_bodies, const Player *player);
 void destroy_boxes(Boxes *boxes);
 
-int boxes_render(Boxes *boxes, Camera *camera);
-int boxes_update(Boxes *boxes, float delta_time);
+int boxes_render(Boxes *boxes, Camera *camera, float alpha);
 
-void boxes_float_in_lava(Boxes *boxes, Lava *lava);
+int boxes_float_in_lava(Boxes *boxes, Lava *lava);
 
 int boxes_add_to_physical_world(const Boxes *boxes,
                                 Physical_world *Physical_world);
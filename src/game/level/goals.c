@@ -133,6 +133,13 @@ static int goals_render_core(const Goals *goals,
         goals->points[goal_index],
         vec(0.0f, sinf(goals->angle) * 10.0f));
 
+    if (!camera_is_rect_visible(
+            camera,
+            rect(position.x - GOAL_RADIUS, position.y - GOAL_RADIUS,
+                 2.0f * GOAL_RADIUS, 2.0f * GOAL_RADIUS))) {
+        return 0;
+    }
+
     if (camera_fill_triangle(
             camera,
             triangle_mat3x3_product(
@@ -2,6 +2,7 @@
 #include "system/stacktrace.h"
 #include <stdio.h>
 
+#include "aabb_tree.h"
 #include "color.h"
 #include "game/level/lava/wavy_rect.h"
 #include "lava.h"
@@ -17,6 +18,14 @@ struct Lava {
     Lt *lt;
     size_t rects_count;
     Wavy_rect **rects;
+    Rect *hitboxes;
+    AabbTree *tree;
+
+    // Scratch space of lava_float_rigid_bodies
+    size_t bodies_capacity;
+    Rect *bodies;
+    Vec *forces;
+    Vec *dampers;
 };
 
 Lava *create_lava_from_line_stream(LineStream *line_stream)
@@ -46,13 +55,33 @@ Lava *create_lava_from_line_stream(LineStream *line_stream)
         RETURN_LT(lt, NULL);
     }
 
+    lava->hitboxes = PUSH_LT(lt, nth_calloc(lava->rects_count + 1, sizeof(Rect)), free);
+    if (lava->hitboxes == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
     for (size_t i = 0; i < lava->rects_count; ++i) {
         lava->rects[i] = PUSH_LT(lt, create_wavy_rect_from_line_stream(line_stream), destroy_wavy_rect);
         if (lava->rects[i] == NULL) {
             RETURN_LT(lt, NULL);
         }
+
+        lava->hitboxes[i] = wavy_rect_hitbox(lava->rects[i]);
+    }
+
+    lava->tree = PUSH_LT(
+        lt,
+        create_aabb_tree(lava->hitboxes, lava->rects_count),
+        destroy_aabb_tree);
+    if (lava->tree == NULL) {
+        RETURN_LT(lt, NULL);
     }
 
+    lava->bodies_capacity = 0;
+    lava->bodies = NULL;
+    lava->forces = NULL;
+    lava->dampers = NULL;
+
     lava->lt = lt;
 
     return lava;
@@ -93,35 +122,124 @@ int lava_update(Lava *lava, float delta_time)
     return 0;
 }
 
+static int lava_overlaps_rect_visit(void *param, size_t index)
+{
+    (void) param;
+    (void) index;
+    // Any overlap is enough, so the query is stopped right away
+    return -1;
+}
+
 bool lava_overlaps_rect(const Lava *lava,
                         Rect rect)
 {
     trace_assert(lava);
 
-    for (size_t i = 0; i < lava->rects_count; ++i) {
-        if (rects_overlap(wavy_rect_hitbox(lava->rects[i]), rect)) {
-            return true;
-        }
+    return aabb_tree_query(lava->tree, rect, lava_overlaps_rect_visit, NULL) < 0;
+}
+
+bool lava_raycast(const Lava *lava, Vec begin, Vec end, float *t)
+{
+    trace_assert(lava);
+    trace_assert(t);
+
+    size_t index = 0;
+    return aabb_tree_raycast(lava->tree, begin, end, NULL, NULL, &index, t);
+}
+
+typedef struct {
+    const Rect *hitboxes;
+    Rect object;
+    Vec *force;
+    Vec *damper;
+} Float_body;
+
+static int lava_float_body_visit(void *param, size_t index)
+{
+    Float_body *body = param;
+
+    const Rect overlap_area = rects_overlap_area(body->object, body->hitboxes[index]);
+    const float k = overlap_area.w * overlap_area.h / (body->object.w * body->object.h);
+    body->force->y -= k * LAVA_BOINGNESS;
+    body->damper->y -= 0.9f;
+
+    return 0;
+}
+
+static int lava_reserve_bodies(Lava *lava, size_t count)
+{
+    trace_assert(lava);
+
+    if (count <= lava->bodies_capacity) {
+        return 0;
+    }
+
+    Rect *bodies = nth_calloc(count, sizeof(Rect));
+    if (bodies == NULL) {
+        return -1;
+    }
+
+    Vec *forces = nth_calloc(count, sizeof(Vec));
+    if (forces == NULL) {
+        free(bodies);
+        return -1;
+    }
+
+    Vec *dampers = nth_calloc(count, sizeof(Vec));
+    if (dampers == NULL) {
+        free(bodies);
+        free(forces);
+        return -1;
+    }
+
+    if (lava->bodies_capacity == 0) {
+        lava->bodies = PUSH_LT(lava->lt, bodies, free);
+        lava->forces = PUSH_LT(lava->lt, forces, free);
+        lava->dampers = PUSH_LT(lava->lt, dampers, free);
+    } else {
+        lava->bodies = RESET_LT(lava->lt, lava->bodies, bodies);
+        lava->forces = RESET_LT(lava->lt, lava->forces, forces);
+        lava->dampers = RESET_LT(lava->lt, lava->dampers, dampers);
     }
+    lava->bodies_capacity = count;
 
     return 0;
 }
 
-void lava_float_rigid_body(Lava *lava, RigidBodies *rigid_bodies, RigidBodyId id)
+int lava_float_rigid_bodies(Lava *lava,
+                            RigidBodies *rigid_bodies,
+                            const RigidBodyId *ids,
+                            size_t count)
 {
     trace_assert(lava);
+    trace_assert(rigid_bodies);
+    trace_assert(ids || count == 0);
 
-    const Rect object_hitbox = rigid_bodies_hitbox(rigid_bodies, id);
-    for (size_t i = 0; i < lava->rects_count; ++i) {
-        const Rect lava_hitbox = wavy_rect_hitbox(lava->rects[i]);
-        if (rects_overlap(object_hitbox, lava_hitbox)) {
-            const Rect overlap_area = rects_overlap_area(object_hitbox, lava_hitbox);
-            const float k = overlap_area.w * overlap_area.h / (object_hitbox.w * object_hitbox.h);
-            rigid_bodies_apply_force(
-                rigid_bodies,
-                id,
-                vec(0.0f, -k * LAVA_BOINGNESS));
-            rigid_bodies_damper(rigid_bodies, id, vec(0.0f, -0.9f));
-        }
+    if (count == 0 || lava->rects_count == 0) {
+        return 0;
+    }
+
+    if (lava_reserve_bodies(lava, count) < 0) {
+        return -1;
+    }
+
+    rigid_bodies_hitboxes(rigid_bodies, ids, count, lava->bodies);
+
+    for (size_t i = 0; i < count; ++i) {
+        lava->forces[i] = vec(0.0f, 0.0f);
+        lava->dampers[i] = vec(0.0f, 0.0f);
+
+        Float_body body = {
+            .hitboxes = lava->hitboxes,
+            .object = lava->bodies[i],
+            .force = &lava->forces[i],
+            .damper = &lava->dampers[i]
+        };
+
+        aabb_tree_query(lava->tree, lava->bodies[i], lava_float_body_visit, &body);
     }
+
+    rigid_bodies_apply_forces(rigid_bodies, ids, lava->forces, lava->dampers, count);
+
+    return 0;
 }
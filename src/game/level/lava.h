@@ -19,6 +19,19 @@ int lava_update(Lava *lava, float delta_time);
 
 bool lava_overlaps_rect(const Lava *lava, Rect rect);
 
-void lava_float_rigid_body(Lava *lava, RigidBodies *rigid_bodies, RigidBodyId id);
+/** \brief Finds the first lava rect hit by the segment from begin to end.
+ *
+ * Stores the fraction t of the segment before the hit.
+ */
+bool lava_raycast(const Lava *lava, Vec begin, Vec end, float *t);
+
+/** \brief Pushes the bodies that are in the lava up and slows them down.
+ *
+ * All of the bodies are handled in one pass over the lava tree.
+ */
+int lava_float_rigid_bodies(Lava *lava,
+                            RigidBodies *rigid_bodies,
+                            const RigidBodyId *ids,
+                            size_t count);
 
 #endif  // LAVA_H_
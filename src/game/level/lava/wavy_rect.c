@@ -1,8 +1,9 @@
 #include <SDL2/SDL.h>
 #include "system/stacktrace.h"
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 #include "math/pi.h"
 #include "system/line_stream.h"
@@ -12,6 +13,8 @@
 #include "wavy_rect.h"
 
 #define WAVE_PILLAR_WIDTH 10.0f
+#define WAVE_MAX_HEIGHT 5.0f
+#define WAVE_SEED 42
 
 struct Wavy_rect
 {
@@ -20,6 +23,14 @@ struct Wavy_rect
     Rect rect;
     Color color;
     float angle;
+
+    // The i-th pillar goes up and down by amplitudes[i] * sin(angle + i)
+    size_t pillars_count;
+    float *amplitudes;
+
+    // Scratch space of wavy_rect_render
+    Rect *pillars;
+    Color *colors;
 };
 
 Wavy_rect *create_wavy_rect(Rect rect, Color color)
@@ -37,6 +48,41 @@ Wavy_rect *create_wavy_rect(Rect rect, Color color)
     wavy_rect->rect = rect;
     wavy_rect->color = color;
     wavy_rect->angle = 0.0f;
+    wavy_rect->pillars_count = (size_t) fmaxf(0.0f, ceilf(rect.w / WAVE_PILLAR_WIDTH));
+
+    wavy_rect->amplitudes = PUSH_LT(
+        lt,
+        nth_calloc(wavy_rect->pillars_count + 1, sizeof(float)),
+        free);
+    if (wavy_rect->amplitudes == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    wavy_rect->pillars = PUSH_LT(
+        lt,
+        nth_calloc(wavy_rect->pillars_count + 1, sizeof(Rect)),
+        free);
+    if (wavy_rect->pillars == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    wavy_rect->colors = PUSH_LT(
+        lt,
+        nth_calloc(wavy_rect->pillars_count + 1, sizeof(Color)),
+        free);
+    if (wavy_rect->colors == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    // Every lava looks the same, so the amplitudes come from a fixed
+    // seed. A local generator leaves the state of rand() alone.
+    uint32_t seed = WAVE_SEED;
+    for (size_t i = 0; i < wavy_rect->pillars_count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        wavy_rect->amplitudes[i] = (float) ((seed >> 16) % 50) * 0.1f;
+        wavy_rect->colors[i] = color;
+    }
+
     wavy_rect->lt = lt;
 
     return wavy_rect;
@@ -75,26 +121,51 @@ int wavy_rect_render(const Wavy_rect *wavy_rect,
     trace_assert(wavy_rect);
     trace_assert(camera);
 
-    srand(42);
-    for (float wave_scanner = 0;
-         wave_scanner < wavy_rect->rect.w;
-         wave_scanner += WAVE_PILLAR_WIDTH) {
-
-        const float s = (float) (rand() % 50) * 0.1f;
-        if (camera_fill_rect(
-                camera,
-                rect(
-                    wavy_rect->rect.x + wave_scanner,
-                    wavy_rect->rect.y + s * sinf(wavy_rect->angle + wave_scanner / WAVE_PILLAR_WIDTH),
-                    WAVE_PILLAR_WIDTH * 1.20f,
-                    wavy_rect->rect.h),
-                wavy_rect->color) < 0) {
-            return -1;
-        }
+    // The pillars stick out of the rect by the height of the waves
+    // and a fifth of the pillar width
+    if (!camera_is_rect_visible(
+            camera,
+            rect(wavy_rect->rect.x,
+                 wavy_rect->rect.y - WAVE_MAX_HEIGHT,
+                 wavy_rect->rect.w + WAVE_PILLAR_WIDTH * 1.20f,
+                 wavy_rect->rect.h + 2.0f * WAVE_MAX_HEIGHT))) {
+        return 0;
     }
-    srand((unsigned int) time(NULL));
 
-    return 0;
+    // Only the pillars in the visible span are drawn
+    const Rect view = camera_visible_area(camera);
+    const float left = (view.x - wavy_rect->rect.x) / WAVE_PILLAR_WIDTH - 1.20f;
+    const float right = (view.x + view.w - wavy_rect->rect.x) / WAVE_PILLAR_WIDTH;
+    const size_t first = (size_t) fmaxf(0.0f, floorf(left));
+    const size_t last = (size_t) fminf((float) wavy_rect->pillars_count, fmaxf(0.0f, ceilf(right) + 1.0f));
+    if (first >= last) {
+        return 0;
+    }
+
+    // sin(angle + i) of the consecutive pillars is found by rotating
+    // the previous one by a radian
+    const float step_sin = sinf(1.0f);
+    const float step_cos = cosf(1.0f);
+    float wave_sin = sinf(wavy_rect->angle + (float) first);
+    float wave_cos = cosf(wavy_rect->angle + (float) first);
+
+    for (size_t i = first; i < last; ++i) {
+        wavy_rect->pillars[i - first] = rect(
+            wavy_rect->rect.x + (float) i * WAVE_PILLAR_WIDTH,
+            wavy_rect->rect.y + wavy_rect->amplitudes[i] * wave_sin,
+            WAVE_PILLAR_WIDTH * 1.20f,
+            wavy_rect->rect.h);
+
+        const float next_sin = wave_sin * step_cos + wave_cos * step_sin;
+        wave_cos = wave_cos * step_cos - wave_sin * step_sin;
+        wave_sin = next_sin;
+    }
+
+    return camera_fill_rects(
+        camera,
+        wavy_rect->pillars,
+        wavy_rect->colors,
+        last - first);
 }
 
 int wavy_rect_update(Wavy_rect *wavy_rect,
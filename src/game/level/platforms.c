@@ -1,13 +1,13 @@
-#include <SDL2/SDL.h>
 #include "system/stacktrace.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
+#include "aabb_tree.h"
 #include "platforms.h"
 #include "system/lt.h"
-#include "system/lt/lt_adapters.h"
 #include "system/line_stream.h"
 #include "system/nth_alloc.h"
 #include "system/log.h"
@@ -18,8 +18,78 @@ struct Platforms {
     Rect *rects;
     Color *colors;
     size_t rects_size;
+
+    AabbTree *tree;
+    Rect bounds;
 };
 
+static Platforms *platforms_index(Lt *lt, Platforms *platforms)
+{
+    trace_assert(lt);
+    trace_assert(platforms);
+
+    platforms->tree = PUSH_LT(
+        lt,
+        create_aabb_tree(platforms->rects, platforms->rects_size),
+        destroy_aabb_tree);
+    if (platforms->tree == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms->bounds = rect(0.0f, 0.0f, 0.0f, 0.0f);
+    if (platforms->rects_size > 0) {
+        Vec lower = vec(platforms->rects[0].x, platforms->rects[0].y);
+        Vec upper = lower;
+        for (size_t i = 0; i < platforms->rects_size; ++i) {
+            const Rect r = platforms->rects[i];
+            lower = vec(fminf(lower.x, r.x), fminf(lower.y, r.y));
+            upper = vec(fmaxf(upper.x, r.x + r.w), fmaxf(upper.y, r.y + r.h));
+        }
+        platforms->bounds = rect_from_points(lower, upper);
+    }
+
+    platforms->lt = lt;
+
+    return platforms;
+}
+
+Platforms *create_platforms(const Rect *rects,
+                            const Color *colors,
+                            size_t rects_size)
+{
+    trace_assert(rects || rects_size == 0);
+    trace_assert(colors || rects_size == 0);
+
+    Lt *const lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    Platforms *platforms = PUSH_LT(lt, nth_alloc(sizeof(Platforms)), free);
+    if (platforms == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms->rects_size = rects_size;
+
+    platforms->rects = PUSH_LT(lt, nth_alloc(sizeof(Rect) * (rects_size + 1)), free);
+    if (platforms->rects == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms->colors = PUSH_LT(lt, nth_alloc(sizeof(Color) * (rects_size + 1)), free);
+    if (platforms->colors == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    for (size_t i = 0; i < rects_size; ++i) {
+        platforms->rects[i] = rects[i];
+        platforms->colors[i] = colors[i];
+    }
+
+    return platforms_index(lt, platforms);
+}
+
 Platforms *create_platforms_from_line_stream(LineStream *line_stream)
 {
     trace_assert(line_stream);
@@ -66,9 +136,7 @@ Platforms *create_platforms_from_line_stream(LineStream *line_stream)
         platforms->colors[i] = hexstr(color);
     }
 
-    platforms->lt = lt;
-
-    return platforms;
+    return platforms_index(lt, platforms);
 }
 
 void destroy_platforms(Platforms *platforms)
@@ -77,19 +145,80 @@ void destroy_platforms(Platforms *platforms)
     RETURN_LT0(platforms->lt);
 }
 
-/* TODO(#450): platforms do not render their ids in debug mode */
-int platforms_render(const Platforms *platforms,
-                     Camera *camera)
+size_t platforms_count(const Platforms *platforms)
 {
-    for (size_t i = 0; i < platforms->rects_size; ++i) {
-        if (camera_fill_rect(
-                camera,
-                platforms->rects[i],
-                platforms->colors[i]) < 0) {
-            return -1;
-        }
+    trace_assert(platforms);
+    return platforms->rects_size;
+}
+
+Rect platforms_bounds(const Platforms *platforms)
+{
+    trace_assert(platforms);
+    return platforms->bounds;
+}
+
+typedef struct {
+    size_t *indices;
+    size_t count;
+} Gathered_rects;
+
+static int platforms_gather_visit(void *param, size_t index)
+{
+    Gathered_rects *gathered = param;
+    gathered->indices[gathered->count++] = index;
+    return 0;
+}
+
+static int compare_indices(const void *a, const void *b)
+{
+    const size_t i1 = *(const size_t*) a;
+    const size_t i2 = *(const size_t*) b;
+    return (i1 > i2) - (i1 < i2);
+}
+
+size_t platforms_gather(const Platforms *platforms,
+                        Rect area,
+                        size_t *indices,
+                        Rect *rects,
+                        Color *colors)
+{
+    trace_assert(platforms);
+    trace_assert(indices);
+    trace_assert(rects);
+    trace_assert(colors);
+
+    Gathered_rects gathered = {
+        .indices = indices,
+        .count = 0
+    };
+
+    aabb_tree_query(
+        platforms->tree,
+        area,
+        platforms_gather_visit,
+        &gathered);
+
+    // The overlapping platforms must be drawn in the order of the level file
+    qsort(gathered.indices, gathered.count, sizeof(size_t), compare_indices);
+
+    for (size_t i = 0; i < gathered.count; ++i) {
+        rects[i] = platforms->rects[gathered.indices[i]];
+        colors[i] = platforms->colors[gathered.indices[i]];
     }
 
+    return gathered.count;
+}
+
+typedef struct {
+    const Rect *rects;
+    Rect object;
+    int *sides;
+} Touches_rect_sides;
+
+static int platforms_touches_rect_sides_visit(void *param, size_t index)
+{
+    Touches_rect_sides *touches = param;
+    rect_object_impact(touches->object, touches->rects[index], touches->sides);
     return 0;
 }
 
@@ -99,22 +228,152 @@ void platforms_touches_rect_sides(const Platforms *platforms,
 {
     trace_assert(platforms);
 
-    for (size_t i = 0; i < platforms->rects_size; ++i) {
-        rect_object_impact(object, platforms->rects[i], sides);
+    Touches_rect_sides touches = {
+        .rects = platforms->rects,
+        .object = object,
+        .sides = sides
+    };
+
+    aabb_tree_query(
+        platforms->tree,
+        object,
+        platforms_touches_rect_sides_visit,
+        &touches);
+}
+
+typedef struct {
+    size_t after;
+    size_t next;
+} Snap_rect;
+
+static int platforms_snap_rect_visit(void *param, size_t index)
+{
+    Snap_rect *snap = param;
+
+    if (index >= snap->after && index < snap->next) {
+        snap->next = index;
     }
+
+    return 0;
 }
 
 Vec platforms_snap_rect(const Platforms *platforms,
                          Rect *object)
 {
     trace_assert(platforms);
+    trace_assert(object);
+
+    // The result depends on the order of the snaps, so the platforms
+    // are visited in the order of the level file like before the
+    // tree. Every snap moves the object, so the tree is asked again
+    // for the next overlapping platform after the one just snapped.
+    // The state lives on the stack because the bodies are snapped
+    // from several threads at once.
+    Snap_rect snap = {
+        .after = 0,
+        .next = platforms->rects_size
+    };
 
     Vec result = vec(1.0f, 1.0f);
-    for (size_t i = 0; i < platforms->rects_size; ++i) {
-        if (rects_overlap(platforms->rects[i], *object)) {
-            result = vec_entry_mult(result, rect_snap(platforms->rects[i], object));
+    for (;;) {
+        aabb_tree_query(platforms->tree, *object, platforms_snap_rect_visit, &snap);
+        if (snap.next >= platforms->rects_size) {
+            break;
         }
+
+        result = vec_entry_mult(result, rect_snap(platforms->rects[snap.next], object));
+
+        snap.after = snap.next + 1;
+        snap.next = platforms->rects_size;
     }
 
     return result;
 }
+
+typedef struct {
+    const Rect *rects;
+    Rect object;
+    Vec displacement;
+    float time;
+    Vec result;
+} Sweep_rect;
+
+static int platforms_sweep_rect_visit(void *param, size_t index)
+{
+    Sweep_rect *sweep = param;
+
+    Vec mask = vec(1.0f, 1.0f);
+    const float time = rect_time_of_impact(
+        sweep->object,
+        sweep->displacement,
+        sweep->rects[index],
+        &mask);
+
+    if (time < sweep->time) {
+        sweep->time = time;
+        sweep->result = mask;
+    }
+
+    return 0;
+}
+
+Vec platforms_sweep_rect(const Platforms *platforms,
+                         Rect *object,
+                         Vec displacement)
+{
+    trace_assert(platforms);
+    trace_assert(object);
+
+    Sweep_rect sweep = {
+        .rects = platforms->rects,
+        .object = *object,
+        .displacement = displacement,
+        .time = 1.0f,
+        .result = vec(1.0f, 1.0f)
+    };
+
+    // Only the platforms within the area swept by the object can be hit
+    const Rect destination = rect(
+        object->x + displacement.x,
+        object->y + displacement.y,
+        object->w, object->h);
+    aabb_tree_query(
+        platforms->tree,
+        rect_from_points(
+            vec(fminf(object->x, destination.x),
+                fminf(object->y, destination.y)),
+            vec(fmaxf(object->x, destination.x) + object->w,
+                fmaxf(object->y, destination.y) + object->h)),
+        platforms_sweep_rect_visit,
+        &sweep);
+
+    object->x += displacement.x * sweep.time;
+    object->y += displacement.y * sweep.time;
+
+    return sweep.result;
+}
+
+static int platforms_overlaps_rect_visit(void *param, size_t index)
+{
+    (void) param;
+    (void) index;
+    return -1;
+}
+
+bool platforms_overlaps_rect(const Platforms *platforms,
+                             Rect rect)
+{
+    trace_assert(platforms);
+    return aabb_tree_query(platforms->tree, rect, platforms_overlaps_rect_visit, NULL) < 0;
+}
+
+bool platforms_raycast(const Platforms *platforms,
+                       Vec begin, Vec end,
+                       float *t)
+{
+    trace_assert(platforms);
+    trace_assert(t);
+
+    size_t index = 0;
+    return aabb_tree_raycast(platforms->tree, begin, end, NULL, NULL, &index, t);
+}
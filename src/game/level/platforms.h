@@ -1,19 +1,39 @@
 #ifndef PLATFORMS_H_
 #define PLATFORMS_H_
 
-#include <SDL2/SDL.h>
+#include <stdbool.h>
 
-#include "game/camera.h"
+#include "color.h"
 #include "math/rect.h"
 
 typedef struct Platforms Platforms;
 typedef struct LineStream LineStream;
 
+/** \brief Creates the platforms from copies of the rects and the colors.
+ */
+Platforms *create_platforms(const Rect *rects,
+                            const Color *colors,
+                            size_t rects_size);
 Platforms *create_platforms_from_line_stream(LineStream *line_stream);
 void destroy_platforms(Platforms *platforms);
 
-int platforms_render(const Platforms *platforms,
-                     Camera *camera);
+size_t platforms_count(const Platforms *platforms);
+
+/** \brief The rect around all of the platforms.
+ */
+Rect platforms_bounds(const Platforms *platforms);
+
+/** \brief Copies the platforms that overlap the area into rects and
+ * colors in the order of the level file.
+ *
+ * indices is the scratch space for the query. All three must have
+ * room for platforms_count platforms. Returns how many were copied.
+ */
+size_t platforms_gather(const Platforms *platforms,
+                        Rect area,
+                        size_t *indices,
+                        Rect *rects,
+                        Color *colors);
 
 void platforms_touches_rect_sides(const Platforms *platforms,
                                   Rect object,
@@ -21,4 +41,25 @@ void platforms_touches_rect_sides(const Platforms *platforms,
 Vec platforms_snap_rect(const Platforms *platforms,
                         Rect *object);
 
+/** \brief Moves the object by displacement until it hits the first platform.
+ *
+ * Unlike platforms_snap_rect it does not let the object tunnel
+ * through the platforms thinner than the displacement. Returns the
+ * mask for the velocity of the object like platforms_snap_rect does.
+ */
+Vec platforms_sweep_rect(const Platforms *platforms,
+                         Rect *object,
+                         Vec displacement);
+
+bool platforms_overlaps_rect(const Platforms *platforms,
+                             Rect rect);
+
+/** \brief Finds the first platform hit by the segment from begin to end.
+ *
+ * Stores the fraction t of the segment before the hit.
+ */
+bool platforms_raycast(const Platforms *platforms,
+                       Vec begin, Vec end,
+                       float *t);
+
 #endif  // PLATFORMS_H_
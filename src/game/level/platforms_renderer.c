@@ -0,0 +1,327 @@
+#include <SDL2/SDL.h>
+#include "system/stacktrace.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platforms.h"
+#include "platforms_renderer.h"
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+
+// The tiles are that many pixels wide and high on the screen
+#define PLATFORMS_RENDERER_TILE_SIZE 256
+// The grid is not made bigger than that. The textures are only baked
+// for the visible tiles, so that limits just the size of the grid.
+#define PLATFORMS_RENDERER_MAX_TILES 65536
+// The textures of the tiles that were not visible in the last frame
+// are dropped when there are more of them than that
+#define PLATFORMS_RENDERER_MAX_BAKED_TILES 128
+
+typedef struct {
+    SDL_Texture *texture;
+    bool empty;
+    size_t frame;
+} Platforms_tile;
+
+struct PlatformsRenderer {
+    Lt *lt;
+
+    const Platforms *platforms;
+
+    // Scratch space for the visible rects
+    size_t *visible;
+    Rect *visible_rects;
+    Color *visible_colors;
+
+    // The platforms never move, so they are baked into the textures
+    // of a grid of tiles over their bounds. A tile is baked the first
+    // time it is visible, and the whole grid is dropped when the zoom
+    // or the color mode change.
+    Rect bounds;
+    Vec tiles_scale;
+    bool tiles_blackwhite;
+    size_t tiles_columns;
+    size_t tiles_rows;
+    size_t tiles_capacity;
+    Platforms_tile *tiles;
+    size_t baked_count;
+    size_t frame;
+};
+
+PlatformsRenderer *create_platforms_renderer(const Platforms *platforms)
+{
+    trace_assert(platforms);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    PlatformsRenderer *platforms_renderer = PUSH_LT(lt, nth_calloc(1, sizeof(PlatformsRenderer)), free);
+    if (platforms_renderer == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    platforms_renderer->lt = lt;
+
+    platforms_renderer->platforms = platforms;
+
+    const size_t count = platforms_count(platforms);
+
+    platforms_renderer->visible = PUSH_LT(lt, nth_alloc(sizeof(size_t) * (count + 1)), free);
+    if (platforms_renderer->visible == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms_renderer->visible_rects = PUSH_LT(lt, nth_alloc(sizeof(Rect) * (count + 1)), free);
+    if (platforms_renderer->visible_rects == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms_renderer->visible_colors = PUSH_LT(lt, nth_alloc(sizeof(Color) * (count + 1)), free);
+    if (platforms_renderer->visible_colors == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    platforms_renderer->bounds = platforms_bounds(platforms);
+    platforms_renderer->tiles_scale = vec(0.0f, 0.0f);
+    platforms_renderer->tiles_blackwhite = false;
+    platforms_renderer->tiles_columns = 0;
+    platforms_renderer->tiles_rows = 0;
+    platforms_renderer->tiles_capacity = 0;
+    platforms_renderer->tiles = NULL;
+    platforms_renderer->baked_count = 0;
+    platforms_renderer->frame = 0;
+
+    return platforms_renderer;
+}
+
+void platforms_renderer_drop_tiles(PlatformsRenderer *platforms_renderer)
+{
+    trace_assert(platforms_renderer);
+
+    const size_t count = platforms_renderer->tiles_columns * platforms_renderer->tiles_rows;
+    for (size_t i = 0; i < count; ++i) {
+        if (platforms_renderer->tiles[i].texture != NULL) {
+            SDL_DestroyTexture(platforms_renderer->tiles[i].texture);
+            platforms_renderer->tiles[i].texture = NULL;
+        }
+    }
+
+    platforms_renderer->tiles_columns = 0;
+    platforms_renderer->tiles_rows = 0;
+    platforms_renderer->baked_count = 0;
+}
+
+void destroy_platforms_renderer(PlatformsRenderer *platforms_renderer)
+{
+    trace_assert(platforms_renderer);
+    platforms_renderer_drop_tiles(platforms_renderer);
+    RETURN_LT0(platforms_renderer->lt);
+}
+
+/* Puts the platforms that overlap the area into visible_rects and
+ * visible_colors */
+static size_t platforms_renderer_gather(PlatformsRenderer *platforms_renderer, Rect area)
+{
+    trace_assert(platforms_renderer);
+
+    return platforms_gather(
+        platforms_renderer->platforms,
+        area,
+        platforms_renderer->visible,
+        platforms_renderer->visible_rects,
+        platforms_renderer->visible_colors);
+}
+
+static int platforms_renderer_render_rects(PlatformsRenderer *platforms_renderer,
+                                           Camera *camera)
+{
+    trace_assert(platforms_renderer);
+    trace_assert(camera);
+
+    const size_t count = platforms_renderer_gather(platforms_renderer, camera_visible_area(camera));
+
+    camera_count_culled(camera, count, platforms_count(platforms_renderer->platforms) - count);
+
+    return camera_fill_rects(
+        camera,
+        platforms_renderer->visible_rects,
+        platforms_renderer->visible_colors,
+        count);
+}
+
+/* Makes the grid of the tiles match the camera. Returns false if the
+ * tiles can not be used at this zoom. */
+static bool platforms_renderer_prepare_tiles(PlatformsRenderer *platforms_renderer,
+                                             const Camera *camera)
+{
+    trace_assert(platforms_renderer);
+    trace_assert(camera);
+
+    const Vec scale = camera_pixel_scale(camera);
+    const bool blackwhite = camera_is_blackwhite_mode(camera);
+
+    if (platforms_renderer->tiles_columns > 0 &&
+        platforms_renderer->tiles_scale.x == scale.x &&
+        platforms_renderer->tiles_scale.y == scale.y &&
+        platforms_renderer->tiles_blackwhite == blackwhite) {
+        return true;
+    }
+
+    platforms_renderer_drop_tiles(platforms_renderer);
+
+    if (platforms_count(platforms_renderer->platforms) == 0 || scale.x <= 0.0f || scale.y <= 0.0f) {
+        return false;
+    }
+
+    const Rect bounds = platforms_renderer->bounds;
+    const float columns = fmaxf(1.0f, ceilf(bounds.w * scale.x / (float) PLATFORMS_RENDERER_TILE_SIZE));
+    const float rows = fmaxf(1.0f, ceilf(bounds.h * scale.y / (float) PLATFORMS_RENDERER_TILE_SIZE));
+    if (columns * rows > (float) PLATFORMS_RENDERER_MAX_TILES) {
+        return false;
+    }
+
+    const size_t columns_count = (size_t) columns;
+    const size_t rows_count = (size_t) rows;
+
+    const size_t count = columns_count * rows_count;
+    if (count > platforms_renderer->tiles_capacity) {
+        Platforms_tile *tiles = nth_calloc(count, sizeof(Platforms_tile));
+        if (tiles == NULL) {
+            return false;
+        }
+
+        if (platforms_renderer->tiles == NULL) {
+            platforms_renderer->tiles = PUSH_LT(platforms_renderer->lt, tiles, free);
+        } else {
+            platforms_renderer->tiles = RESET_LT(platforms_renderer->lt, platforms_renderer->tiles, tiles);
+        }
+        platforms_renderer->tiles_capacity = count;
+    } else {
+        memset(platforms_renderer->tiles, 0, sizeof(Platforms_tile) * count);
+    }
+
+    platforms_renderer->tiles_columns = columns_count;
+    platforms_renderer->tiles_rows = rows_count;
+    platforms_renderer->tiles_scale = scale;
+    platforms_renderer->tiles_blackwhite = blackwhite;
+
+    return true;
+}
+
+static void platforms_renderer_evict_tiles(PlatformsRenderer *platforms_renderer)
+{
+    trace_assert(platforms_renderer);
+
+    const size_t count = platforms_renderer->tiles_columns * platforms_renderer->tiles_rows;
+    for (size_t i = 0;
+         i < count && platforms_renderer->baked_count > PLATFORMS_RENDERER_MAX_BAKED_TILES;
+         ++i) {
+        Platforms_tile *tile = &platforms_renderer->tiles[i];
+        if (tile->texture != NULL && tile->frame != platforms_renderer->frame) {
+            SDL_DestroyTexture(tile->texture);
+            tile->texture = NULL;
+            platforms_renderer->baked_count--;
+        }
+    }
+}
+
+static int platforms_renderer_render_tiles(PlatformsRenderer *platforms_renderer,
+                                           Camera *camera)
+{
+    trace_assert(platforms_renderer);
+    trace_assert(camera);
+
+    const size_t platforms_total = platforms_count(platforms_renderer->platforms);
+    const Rect bounds = platforms_renderer->bounds;
+    const Rect area = camera_visible_area(camera);
+    if (!rects_overlap(area, bounds)) {
+        camera_count_culled(camera, 0, platforms_total);
+        return 0;
+    }
+
+    const float tile_w = (float) PLATFORMS_RENDERER_TILE_SIZE / platforms_renderer->tiles_scale.x;
+    const float tile_h = (float) PLATFORMS_RENDERER_TILE_SIZE / platforms_renderer->tiles_scale.y;
+    const float max_column = (float) (platforms_renderer->tiles_columns - 1);
+    const float max_row = (float) (platforms_renderer->tiles_rows - 1);
+
+    const size_t column_begin = (size_t) fminf(max_column, fmaxf(0.0f, floorf((area.x - bounds.x) / tile_w)));
+    const size_t column_end = (size_t) fminf(max_column, floorf((area.x + area.w - bounds.x) / tile_w)) + 1;
+    const size_t row_begin = (size_t) fminf(max_row, fmaxf(0.0f, floorf((area.y - bounds.y) / tile_h)));
+    const size_t row_end = (size_t) fminf(max_row, floorf((area.y + area.h - bounds.y) / tile_h)) + 1;
+
+    platforms_renderer->frame++;
+    size_t drawn = 0;
+
+    for (size_t row = row_begin; row < row_end; ++row) {
+        for (size_t column = column_begin; column < column_end; ++column) {
+            Platforms_tile *tile = &platforms_renderer->tiles[row * platforms_renderer->tiles_columns + column];
+            if (tile->empty) {
+                continue;
+            }
+
+            const Rect tile_area = rect(
+                bounds.x + (float) column * tile_w,
+                bounds.y + (float) row * tile_h,
+                tile_w, tile_h);
+
+            if (tile->texture == NULL) {
+                const size_t count = platforms_renderer_gather(platforms_renderer, tile_area);
+                if (count == 0) {
+                    tile->empty = true;
+                    continue;
+                }
+
+                tile->texture = camera_bake_rects(
+                    camera,
+                    tile_area,
+                    PLATFORMS_RENDERER_TILE_SIZE, PLATFORMS_RENDERER_TILE_SIZE,
+                    platforms_renderer->visible_rects,
+                    platforms_renderer->visible_colors,
+                    count);
+                if (tile->texture == NULL) {
+                    return -1;
+                }
+                platforms_renderer->baked_count++;
+            }
+
+            tile->frame = platforms_renderer->frame;
+
+            if (camera_blit(camera, tile->texture, tile_area) < 0) {
+                return -1;
+            }
+            drawn++;
+        }
+    }
+
+    // The tiles hold the platforms baked into them, so those are the
+    // platforms that were drawn
+    const size_t gathered = drawn == 0 ? 0 : platforms_renderer_gather(
+        platforms_renderer,
+        rect(bounds.x + (float) column_begin * tile_w,
+             bounds.y + (float) row_begin * tile_h,
+             (float) (column_end - column_begin) * tile_w,
+             (float) (row_end - row_begin) * tile_h));
+    camera_count_culled(camera, gathered, platforms_total - gathered);
+
+    if (platforms_renderer->baked_count > PLATFORMS_RENDERER_MAX_BAKED_TILES) {
+        platforms_renderer_evict_tiles(platforms_renderer);
+    }
+
+    return 0;
+}
+
+/* TODO(#450): platforms do not render their ids in debug mode */
+int platforms_renderer_render(PlatformsRenderer *platforms_renderer,
+                              Camera *camera)
+{
+    trace_assert(platforms_renderer);
+    trace_assert(camera);
+
+    if (camera_can_bake(camera) && platforms_renderer_prepare_tiles(platforms_renderer, camera)) {
+        return platforms_renderer_render_tiles(platforms_renderer, camera);
+    }
+
+    return platforms_renderer_render_rects(platforms_renderer, camera);
+}
@@ -0,0 +1,32 @@
+#ifndef PLATFORMS_RENDERER_H_
+#define PLATFORMS_RENDERER_H_
+
+#include "game/camera.h"
+
+typedef struct PlatformsRenderer PlatformsRenderer;
+typedef struct Platforms Platforms;
+
+/** \brief Creates the renderer of the platforms.
+ *
+ * The platforms must outlive the renderer.
+ */
+PlatformsRenderer *create_platforms_renderer(const Platforms *platforms);
+void destroy_platforms_renderer(PlatformsRenderer *platforms_renderer);
+
+/** \brief Renders the platforms that are on the screen.
+ *
+ * The platforms are baked into textures of screen sized tiles that
+ * are kept until the zoom changes. The camera modes that can not be
+ * baked draw the platforms rect by rect.
+ */
+int platforms_renderer_render(PlatformsRenderer *platforms_renderer,
+                              Camera *camera);
+
+/** \brief Drops the baked tiles, so they are baked again when needed.
+ *
+ * Call it when the renderer loses its textures
+ * (SDL_RENDER_TARGETS_RESET, SDL_RENDER_DEVICE_RESET).
+ */
+void platforms_renderer_drop_tiles(PlatformsRenderer *platforms_renderer);
+
+#endif  // PLATFORMS_RENDERER_H_
@@ -41,6 +41,9 @@ struct Player {
     Color color;
 
     Vec checkpoint;
+    // The camera snaps to the player instead of sweeping after the
+    // player appears somewhere new
+    bool teleported;
 
     int play_die_cue;
 };
@@ -102,6 +105,7 @@ Player *create_player_from_line_stream(LineStream *line_stream, RigidBodies *rig
     player->jump_threshold = 0;
     player->color = color;
     player->checkpoint = vec(x, y);
+    player->teleported = true;
     player->play_die_cue = 0;
     player->state = PLAYER_STATE_ALIVE;
 
@@ -110,27 +114,26 @@ Player *create_player_from_line_stream(LineStream *line_stream, RigidBodies *rig
 
 void destroy_player(Player * player)
 {
+    rigid_bodies_remove(player->rigid_bodies, player->alive_body_id);
     RETURN_LT0(player->lt);
 }
 
 int player_render(const Player * player,
-                  Camera *camera)
+                  Camera *camera,
+                  float alpha)
 {
     trace_assert(player);
     trace_assert(camera);
 
-    char debug_text[256];
-
     switch (player->state) {
     case PLAYER_STATE_ALIVE: {
-        snprintf(debug_text, 256, "Jump: %d", player->jump_threshold);
-        Rect hitbox = rigid_bodies_hitbox(player->rigid_bodies, player->alive_body_id);
+        Rect hitbox = rigid_bodies_interpolated_hitbox(player->rigid_bodies, player->alive_body_id, alpha);
 
-        if (camera_render_debug_text(camera, debug_text, vec(hitbox.x, hitbox.y - 20.0f)) < 0) {
+        if (camera_render_debug_long(camera, "Jump: ", player->jump_threshold, vec(hitbox.x, hitbox.y - 20.0f)) < 0) {
             return -1;
         }
 
-        return rigid_bodies_render(player->rigid_bodies, player->alive_body_id, camera);
+        return rigid_bodies_render(player->rigid_bodies, player->alive_body_id, camera, alpha);
     }
 
     case PLAYER_STATE_DYING:
@@ -149,8 +152,6 @@ void player_update(Player *player,
 
     switch (player->state) {
     case PLAYER_STATE_ALIVE: {
-        rigid_bodies_update(player->rigid_bodies, player->alive_body_id, delta_time);
-
         const Rect hitbox = rigid_bodies_hitbox(player->rigid_bodies, player->alive_body_id);
 
 
@@ -173,6 +174,11 @@ void player_update(Player *player,
                 player->rigid_bodies,
                 player->alive_body_id,
                 player->checkpoint);
+            player->teleported = true;
+            rigid_bodies_freeze(
+                player->rigid_bodies,
+                player->alive_body_id,
+                false);
             player->state = PLAYER_STATE_ALIVE;
         }
     } break;
@@ -240,6 +246,7 @@ void player_die(Player *player)
 
         player->play_die_cue = 1;
         explosion_start(player->dying_body, vec(hitbox.x, hitbox.y));
+        rigid_bodies_freeze(player->rigid_bodies, player->alive_body_id, true);
         player->state = PLAYER_STATE_DYING;
     }
 }
@@ -254,11 +261,16 @@ void player_focus_camera(Player *player,
         player->rigid_bodies,
         player->alive_body_id);
 
-    camera_center_at(
-        camera,
-        vec_sum(
-            vec(player_hitbox.x, player_hitbox.y),
-            vec(0.0f, -player_hitbox.h * 0.5f)));
+    const Vec center = vec_sum(
+        vec(player_hitbox.x, player_hitbox.y),
+        vec(0.0f, -player_hitbox.h * 0.5f));
+
+    if (player->teleported) {
+        camera_snap_to(camera, center);
+        player->teleported = false;
+    } else {
+        camera_center_at(camera, center);
+    }
 }
 
 void player_hide_goals(const Player *player,
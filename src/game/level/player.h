@@ -20,7 +20,8 @@ Player *create_player_from_line_stream(LineStream *line_stream, RigidBodies *rig
 void destroy_player(Player * player);
 
 int player_render(const Player * player,
-                  Camera *camera);
+                  Camera *camera,
+                  float alpha);
 void player_update(Player * player,
                    float delta_time);
 void player_touches_rect_sides(Player *player,
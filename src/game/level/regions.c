@@ -1,11 +1,17 @@
 #include "system/stacktrace.h"
+#include <stdio.h>
+#include <stdlib.h>
 
+#include "aabb_tree.h"
+#include "dynarray.h"
 #include "ebisp/gc.h"
 #include "ebisp/interpreter.h"
 #include "ebisp/parser.h"
 #include "ebisp/scope.h"
 #include "player.h"
 #include "regions.h"
+#include "regions/overlaps.h"
+#include "rigid_bodies.h"
 #include "script.h"
 #include "system/str.h"
 #include "system/line_stream.h"
@@ -13,10 +19,7 @@
 #include "system/lt.h"
 #include "system/nth_alloc.h"
 
-enum RegionState {
-    RS_PLAYER_INSIDE = 0,
-    RS_PLAYER_OUTSIDE
-};
+#define REGIONS_SCRIPT_MAX_LENGTH 64
 
 struct Regions
 {
@@ -25,7 +28,14 @@ struct Regions
     Rect *rects;
     Color *colors;
     Script **scripts;
-    enum RegionState *states;
+    AabbTree *tree;
+
+    Dynarray *watched_bodies;
+    // The overlaps of the last update, sorted by overlaps_changes.
+    // The player is the occupant 0. A watched body is the occupant
+    // id + 1, so its overlaps outlive the changes of the watched list.
+    Dynarray *overlaps;
+    Dynarray *previous_overlaps;
 };
 
 Regions *create_regions_from_line_stream(LineStream *line_stream, Broadcast *broadcast)
@@ -78,11 +88,18 @@ Regions *create_regions_from_line_stream(LineStream *line_stream, Broadcast *bro
         RETURN_LT(lt, NULL);
     }
 
-    regions->states = PUSH_LT(
-        lt,
-        nth_alloc(sizeof(enum RegionState) * regions->count),
-        free);
-    if (regions->states == NULL) {
+    regions->watched_bodies = PUSH_LT(lt, create_dynarray(sizeof(RigidBodyId)), destroy_dynarray);
+    if (regions->watched_bodies == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    regions->overlaps = PUSH_LT(lt, create_dynarray(sizeof(Overlap)), destroy_dynarray);
+    if (regions->overlaps == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    regions->previous_overlaps = PUSH_LT(lt, create_dynarray(sizeof(Overlap)), destroy_dynarray);
+    if (regions->previous_overlaps == NULL) {
         RETURN_LT(lt, NULL);
     }
 
@@ -123,10 +140,15 @@ Regions *create_regions_from_line_stream(LineStream *line_stream, Broadcast *bro
             log_fail("Script does not provide on-leave callback\n");
             RETURN_LT(lt, NULL);
         }
-
-        regions->states[i] = RS_PLAYER_OUTSIDE;
     }
 
+    regions->tree = PUSH_LT(
+        lt,
+        create_aabb_tree(regions->rects, regions->count),
+        destroy_aabb_tree);
+    if (regions->tree == NULL) {
+        RETURN_LT(lt, NULL);
+    }
 
     return regions;
 }
@@ -137,32 +159,169 @@ void destroy_regions(Regions *regions)
     RETURN_LT0(regions->lt);
 }
 
-void regions_player_enter(Regions *regions, Player *player)
+int regions_watch_body(Regions *regions, RigidBodyId id)
 {
     trace_assert(regions);
-    trace_assert(player);
 
-    for (size_t i = 0; i < regions->count; ++i) {
-        if (regions->states[i] == RS_PLAYER_OUTSIDE &&
-            player_overlaps_rect(player, regions->rects[i])) {
-            regions->states[i] = RS_PLAYER_INSIDE;
-            script_eval(regions->scripts[i], "(on-enter)");
+    if (dynarray_contains(regions->watched_bodies, &id)) {
+        return 0;
+    }
+
+    return dynarray_push(regions->watched_bodies, &id);
+}
+
+void regions_unwatch_body(Regions *regions, RigidBodyId id)
+{
+    trace_assert(regions);
+
+    const size_t watched_count = dynarray_count(regions->watched_bodies);
+    const RigidBodyId *watched_bodies = dynarray_data(regions->watched_bodies);
+    for (size_t i = 0; i < watched_count; ++i) {
+        if (watched_bodies[i] == id) {
+            dynarray_delete_at(regions->watched_bodies, i);
+            return;
         }
     }
 }
 
-void regions_player_leave(Regions *regions, Player *player)
+typedef struct {
+    Regions *regions;
+    size_t occupant;
+    const Player *player;
+    int result;
+} Occupant;
+
+static int regions_push_overlap(void *param, size_t region)
+{
+    Occupant *occupant = param;
+    trace_assert(occupant);
+
+    // The player must also be alive to be in a region
+    if (occupant->player != NULL &&
+        !player_overlaps_rect(occupant->player, occupant->regions->rects[region])) {
+        return 0;
+    }
+
+    const Overlap overlap = {
+        .occupant = occupant->occupant,
+        .region = region
+    };
+
+    if (dynarray_push(occupant->regions->overlaps, &overlap) < 0) {
+        occupant->result = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int regions_find_overlaps(Regions *regions,
+                                 size_t occupant,
+                                 Rect hitbox,
+                                 const Player *player)
+{
+    trace_assert(regions);
+
+    Occupant param = {
+        .regions = regions,
+        .occupant = occupant,
+        .player = player,
+        .result = 0
+    };
+
+    aabb_tree_query(regions->tree, hitbox, regions_push_overlap, &param);
+    if (param.result < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void regions_notify(Regions *regions,
+                           const Overlap *overlap,
+                           const char *event)
+{
+    trace_assert(regions);
+    trace_assert(overlap);
+
+    Script *script = regions->scripts[overlap->region];
+
+    if (overlap->occupant == 0) {
+        char source_code[REGIONS_SCRIPT_MAX_LENGTH];
+        snprintf(source_code, REGIONS_SCRIPT_MAX_LENGTH, "(on-%s)", event);
+        script_eval(script, source_code);
+        return;
+    }
+
+    char callback[REGIONS_SCRIPT_MAX_LENGTH];
+    snprintf(callback, REGIONS_SCRIPT_MAX_LENGTH, "on-body-%s", event);
+    if (!script_has_scope_value(script, callback)) {
+        return;
+    }
+
+    char source_code[REGIONS_SCRIPT_MAX_LENGTH];
+    snprintf(source_code, REGIONS_SCRIPT_MAX_LENGTH, "(on-body-%s %ld)",
+             event, (long int) (overlap->occupant - 1));
+    script_eval(script, source_code);
+}
+
+static void regions_notify_enter(void *param, const Overlap *overlap)
+{
+    regions_notify(param, overlap, "enter");
+}
+
+static void regions_notify_leave(void *param, const Overlap *overlap)
+{
+    regions_notify(param, overlap, "leave");
+}
+
+int regions_update(Regions *regions,
+                   const Player *player,
+                   const RigidBodies *rigid_bodies)
 {
     trace_assert(regions);
     trace_assert(player);
+    trace_assert(rigid_bodies);
 
-    for (size_t i = 0; i < regions->count; ++i) {
-        if (regions->states[i] == RS_PLAYER_INSIDE &&
-            !player_overlaps_rect(player, regions->rects[i])) {
-            regions->states[i] = RS_PLAYER_OUTSIDE;
-            script_eval(regions->scripts[i], "(on-leave)");
+    Dynarray *previous_overlaps = regions->overlaps;
+    regions->overlaps = regions->previous_overlaps;
+    regions->previous_overlaps = previous_overlaps;
+    dynarray_clear(regions->overlaps);
+
+    if (regions_find_overlaps(regions, 0, player_hitbox(player), player) < 0) {
+        return -1;
+    }
+
+    const RigidBodyId *watched_bodies = dynarray_data(regions->watched_bodies);
+    for (size_t i = 0; i < dynarray_count(regions->watched_bodies);) {
+        // The removed bodies leave their regions and are not watched
+        // anymore
+        if (!rigid_bodies_is_alive(rigid_bodies, watched_bodies[i])) {
+            dynarray_delete_at(regions->watched_bodies, i);
+            continue;
+        }
+
+        if (regions_find_overlaps(
+                regions,
+                watched_bodies[i] + 1,
+                rigid_bodies_hitbox(rigid_bodies, watched_bodies[i]),
+                NULL) < 0) {
+            return -1;
         }
+
+        ++i;
     }
+
+    overlaps_changes(
+        dynarray_data(regions->overlaps),
+        dynarray_count(regions->overlaps),
+        dynarray_data(regions->previous_overlaps),
+        dynarray_count(regions->previous_overlaps),
+        regions_notify_enter,
+        regions_notify_leave,
+        regions);
+
+    return 0;
 }
 
 int regions_render(Regions *regions, Camera *camera)
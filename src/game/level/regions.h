@@ -2,6 +2,7 @@
 #define REGIONS_H_
 
 #include "math/rect.h"
+#include "game/level/rigid_bodies.h"
 
 typedef struct Regions Regions;
 typedef struct Player Player;
@@ -14,7 +15,28 @@ void destroy_regions(Regions *regions);
 
 int regions_render(Regions *regions, Camera *camera);
 
-void regions_player_enter(Regions *regions, Player *player);
-void regions_player_leave(Regions *regions, Player *player);
+/** \brief Watches the body entering and leaving the regions.
+ *
+ * The scripts of the regions are notified with (on-body-enter id)
+ * and (on-body-leave id) if they provide those callbacks.
+ */
+int regions_watch_body(Regions *regions, RigidBodyId id);
+
+/** \brief Stops watching the body.
+ *
+ * The body leaves its regions on the next update. The removed bodies
+ * are unwatched by regions_update on its own.
+ */
+void regions_unwatch_body(Regions *regions, RigidBodyId id);
+
+/** \brief Notifies the scripts of the regions the player and the
+ * watched bodies entered or left since the last update.
+ *
+ * The player gets (on-enter) and (on-leave). All of the enters are
+ * notified before all of the leaves.
+ */
+int regions_update(Regions *regions,
+                   const Player *player,
+                   const RigidBodies *rigid_bodies);
 
 #endif  // REGIONS_H_
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+
+#include "system/stacktrace.h"
+#include "./overlaps.h"
+
+static int compare_overlaps(const void *a, const void *b)
+{
+    const Overlap *o1 = a;
+    const Overlap *o2 = b;
+
+    if (o1->occupant != o2->occupant) {
+        return o1->occupant < o2->occupant ? -1 : 1;
+    }
+
+    return (o1->region > o2->region) - (o1->region < o2->region);
+}
+
+void overlaps_sort(Overlap *overlaps, size_t count)
+{
+    trace_assert(overlaps || count == 0);
+
+    if (count > 0) {
+        qsort(overlaps, count, sizeof(Overlap), compare_overlaps);
+    }
+}
+
+void overlaps_difference(const Overlap *a, size_t a_count,
+                         const Overlap *b, size_t b_count,
+                         OverlapsVisit visit,
+                         void *param)
+{
+    trace_assert(a || a_count == 0);
+    trace_assert(b || b_count == 0);
+    trace_assert(visit);
+
+    size_t j = 0;
+    for (size_t i = 0; i < a_count; ++i) {
+        while (j < b_count && compare_overlaps(&b[j], &a[i]) < 0) {
+            ++j;
+        }
+
+        if (j >= b_count || compare_overlaps(&b[j], &a[i]) != 0) {
+            visit(param, &a[i]);
+        }
+    }
+}
+
+void overlaps_changes(Overlap *overlaps, size_t count,
+                      const Overlap *previous, size_t previous_count,
+                      OverlapsVisit enter,
+                      OverlapsVisit leave,
+                      void *param)
+{
+    trace_assert(enter);
+    trace_assert(leave);
+
+    // The overlaps of every occupant come in one piece, but the
+    // occupants come in the order they are watched, not by their ids
+    overlaps_sort(overlaps, count);
+
+    overlaps_difference(overlaps, count, previous, previous_count, enter, param);
+    overlaps_difference(previous, previous_count, overlaps, count, leave, param);
+}
@@ -0,0 +1,43 @@
+#ifndef OVERLAPS_H_
+#define OVERLAPS_H_
+
+#include <stddef.h>
+
+/** \brief An occupant (the player or a watched body) inside a region.
+ */
+typedef struct Overlap {
+    size_t occupant;
+    size_t region;
+} Overlap;
+
+/** \brief Sorts the overlaps by occupants and then by regions.
+ */
+void overlaps_sort(Overlap *overlaps, size_t count);
+
+typedef void (*OverlapsVisit)(void *param, const Overlap *overlap);
+
+/** \brief Calls visit with every overlap of a that is missing in b.
+ *
+ * Both arrays must be sorted with overlaps_sort, so it is a single
+ * merge pass. The overlaps are visited in the order of a.
+ */
+void overlaps_difference(const Overlap *a, size_t a_count,
+                         const Overlap *b, size_t b_count,
+                         OverlapsVisit visit,
+                         void *param);
+
+/** \brief Calls enter with every overlap that is new since the
+ * previous overlaps and leave with every one that is gone.
+ *
+ * The overlaps may come in any order and are sorted with
+ * overlaps_sort first, so they can be the previous overlaps of the
+ * next call. The previous overlaps must be sorted already. All of
+ * the enters are visited before all of the leaves.
+ */
+void overlaps_changes(Overlap *overlaps, size_t count,
+                      const Overlap *previous, size_t previous_count,
+                      OverlapsVisit enter,
+                      OverlapsVisit leave,
+                      void *param);
+
+#endif  // OVERLAPS_H_
@@ -1,7 +1,9 @@
+#include <math.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 
-#include "game/camera.h"
+#include "aabb_tree.h"
 #include "game/level/platforms.h"
 #include "system/lt.h"
 #include "system/nth_alloc.h"
@@ -9,30 +11,235 @@
 #include "system/line_stream.h"
 #include "system/str.h"
 #include "system/log.h"
-#include "hashset.h"
+#include "system/worker_pool.h"
 
 #include "./rigid_bodies.h"
+#include "./rigid_bodies/spatial_grid.h"
+#include "./rigid_bodies/sweep_and_prune.h"
 
 #define RIGID_BODIES_MAX_ID_SIZE 36
+#define RIGID_BODIES_GRID_CELL_SIZE 128.0f
+// A body falls asleep after staying that still for that many frames
+#define RIGID_BODIES_SLEEP_FRAMES 30
+#define RIGID_BODIES_SLEEP_VELOCITY 10.0f
+#define RIGID_BODIES_SLEEP_FORCE 100.0f
+#define RIGID_BODIES_SLEEP_DISTANCE 0.1f
+// Bodies closer than that are touching and share the island
+#define RIGID_BODIES_CONTACT_MARGIN 1.0f
+// Bodies closer than that at the beginning of the step are going to
+// be checked for collisions during the step
+#define RIGID_BODIES_SPECULATIVE_MARGIN 4.0f
+// Less than that leaves more of the bodies overlapping at the end of
+// a step. More than that barely changes anything, because what is
+// left are the bodies pushed into the ones outside of the speculative
+// margin, which are caught on the next step.
+#define RIGID_BODIES_SOLVER_ITERATIONS 16
+#define RIGID_BODIES_BLOCK_ALIGN 16
+// The dead slots are compacted away once they take that fraction of
+// all of the slots
+#define RIGID_BODIES_COMPACT_RATIO 4
+#define RIGID_BODIES_NO_SLOT ((size_t) -1)
+// The low bits of a RigidBodyId are the index into the slots and the
+// rest is the generation of the index. The generation is bumped when
+// the body is removed, so the ids held for the removed bodies never
+// point at the bodies that reuse their index. The top bit stays clear
+// so the ids survive the trip through the scripts as numbers.
+#define RIGID_BODIES_ID_INDEX_BITS 20
+#define RIGID_BODIES_ID_INDEX_MASK ((((size_t) 1) << RIGID_BODIES_ID_INDEX_BITS) - 1)
+#define RIGID_BODIES_ID_GENERATION_MASK (((size_t) -1) >> (RIGID_BODIES_ID_INDEX_BITS + 1))
+// That many bodies are integrated or collided with the platforms by
+// a worker at once
+#define RIGID_BODIES_CHUNK_SIZE 1024
+// The query tree is refitted to the moved bodies that many times
+// before it is rebuilt to get tight again
+#define RIGID_BODIES_QUERY_TREE_REFITS 60
+
+/* All of the per-body arrays (columns) live in a single block. The
+ * block is reallocated geometrically as the bodies are added. */
+typedef enum Column {
+    COLUMN_SLOTS = 0,
+    COLUMN_IDS,
+    COLUMN_FREE_IDS,
+    COLUMN_GENERATIONS,
+    COLUMN_REMAP,
+    COLUMN_BODIES,
+    COLUMN_PREVIOUS_POSITIONS,
+    COLUMN_VELOCITIES,
+    COLUMN_MOVEMENTS,
+    COLUMN_COLORS,
+    COLUMN_GROUNDED,
+    COLUMN_FORCES,
+    COLUMN_DELETED,
+    COLUMN_ASLEEP,
+    COLUMN_FROZEN,
+    COLUMN_IDLE_FRAMES,
+    COLUMN_REST_POSITIONS,
+    COLUMN_ISLANDS,
+    COLUMN_RESTLESS,
+    COLUMN_ISLAND_OFFSETS,
+    COLUMN_ISLAND_BEGINS,
+    COLUMN_ISLAND_ITERATIONS,
+
+    COLUMN_N
+} Column;
+
+static const size_t column_sizes[COLUMN_N] = {
+    [COLUMN_SLOTS] = sizeof(size_t),
+    [COLUMN_IDS] = sizeof(RigidBodyId),
+    [COLUMN_FREE_IDS] = sizeof(size_t),
+    [COLUMN_GENERATIONS] = sizeof(size_t),
+    [COLUMN_REMAP] = sizeof(size_t),
+    [COLUMN_BODIES] = sizeof(Rect),
+    [COLUMN_PREVIOUS_POSITIONS] = sizeof(Vec),
+    [COLUMN_VELOCITIES] = sizeof(Vec),
+    [COLUMN_MOVEMENTS] = sizeof(Vec),
+    [COLUMN_COLORS] = sizeof(Color),
+    [COLUMN_GROUNDED] = sizeof(bool),
+    [COLUMN_FORCES] = sizeof(Vec),
+    [COLUMN_DELETED] = sizeof(bool),
+    [COLUMN_ASLEEP] = sizeof(bool),
+    [COLUMN_FROZEN] = sizeof(bool),
+    [COLUMN_IDLE_FRAMES] = sizeof(size_t),
+    [COLUMN_REST_POSITIONS] = sizeof(Vec),
+    [COLUMN_ISLANDS] = sizeof(size_t),
+    [COLUMN_RESTLESS] = sizeof(bool),
+    [COLUMN_ISLAND_OFFSETS] = sizeof(size_t),
+    [COLUMN_ISLAND_BEGINS] = sizeof(size_t),
+    [COLUMN_ISLAND_ITERATIONS] = sizeof(size_t)
+};
 
+/* The broadphase reports every pair once, so the contacts need no
+ * deduplication and the whole buffer is cleared by resetting its
+ * count. */
+typedef struct Contact {
+    size_t i1, i2;
+    bool collided;
+} Contact;
+
+/* The bodies are stored by slots. A RigidBodyId stays the same for
+ * the whole life of the body while its slot changes when the dead
+ * slots are compacted away. The indices of the removed bodies are
+ * reused through the free list with the next generation. */
 struct RigidBodies
 {
     Lt *lt;
     size_t capacity;
     size_t count;
+    size_t deleted_count;
+    char *block;
+
+    // By the index of the id
+    size_t *slots;
+    size_t *generations;
+    size_t ids_count;
+    size_t *free_ids;
+    size_t free_ids_count;
+    // By the slot
+    RigidBodyId *ids;
+    // Bumped by every add and remove. The snapshots can only be
+    // restored over the same set of ids.
+    size_t epoch;
+    size_t *remap;
 
     Rect *bodies;
+    // Positions at the beginning of the last step for the render
+    // interpolation
+    Vec *previous_positions;
     Vec *velocities;
     Vec *movements;
     Color *colors;
     bool *grounded;
     Vec *forces;
     bool *deleted;
-    HashSet *collided;
+    size_t contacts_capacity;
+    size_t contacts_count;
+    Contact *contacts;
+    size_t solver_iterations;
+
+    bool *asleep;
+    bool *frozen;
+    size_t *idle_frames;
+    Vec *rest_positions;
+    size_t *islands;
+    bool *restless;
+
+    // The contacts grouped by islands for the solver. The contacts
+    // of the island i are
+    // island_contacts[island_begins[i], island_begins[i + 1])
+    WorkerPool *workers;
+    size_t island_contacts_capacity;
+    Contact *island_contacts;
+    size_t *island_offsets;
+    size_t *island_begins;
+    // The passes the solver made over the contacts of every island
+    size_t *island_iterations;
+    size_t islands_count;
+
+    // The tree for the queries is updated on the first query after
+    // the bodies changed. It is refitted if the bodies only moved
+    // and rebuilt if the slots changed.
+    AabbTree *query_tree;
+    bool query_tree_stale;
+    bool query_tree_moved;
+    size_t query_tree_refits;
+
+    RigidBodiesStats stats;
+
+    RigidBodiesBroadphase broadphase;
+    SpatialGrid *grid;
+    SweepAndPrune *sweep_and_prune;
 };
 
+static size_t rigid_bodies_block_layout(size_t capacity,
+                                        size_t offsets[COLUMN_N])
+{
+    size_t size = 0;
+
+    for (size_t column = 0; column < COLUMN_N; ++column) {
+        offsets[column] = size;
+        size += column_sizes[column] * capacity;
+        size = (size + RIGID_BODIES_BLOCK_ALIGN - 1) / RIGID_BODIES_BLOCK_ALIGN * RIGID_BODIES_BLOCK_ALIGN;
+    }
+
+    return size;
+}
+
+static void rigid_bodies_bind_block(RigidBodies *rigid_bodies,
+                                    char *block,
+                                    const size_t offsets[COLUMN_N])
+{
+    trace_assert(rigid_bodies);
+    trace_assert(block);
+
+    rigid_bodies->block = block;
+    rigid_bodies->slots = (size_t*) (block + offsets[COLUMN_SLOTS]);
+    rigid_bodies->ids = (RigidBodyId*) (block + offsets[COLUMN_IDS]);
+    rigid_bodies->free_ids = (size_t*) (block + offsets[COLUMN_FREE_IDS]);
+    rigid_bodies->generations = (size_t*) (block + offsets[COLUMN_GENERATIONS]);
+    rigid_bodies->remap = (size_t*) (block + offsets[COLUMN_REMAP]);
+    rigid_bodies->bodies = (Rect*) (block + offsets[COLUMN_BODIES]);
+    rigid_bodies->previous_positions = (Vec*) (block + offsets[COLUMN_PREVIOUS_POSITIONS]);
+    rigid_bodies->velocities = (Vec*) (block + offsets[COLUMN_VELOCITIES]);
+    rigid_bodies->movements = (Vec*) (block + offsets[COLUMN_MOVEMENTS]);
+    rigid_bodies->colors = (Color*) (block + offsets[COLUMN_COLORS]);
+    rigid_bodies->grounded = (bool*) (block + offsets[COLUMN_GROUNDED]);
+    rigid_bodies->forces = (Vec*) (block + offsets[COLUMN_FORCES]);
+    rigid_bodies->deleted = (bool*) (block + offsets[COLUMN_DELETED]);
+    rigid_bodies->asleep = (bool*) (block + offsets[COLUMN_ASLEEP]);
+    rigid_bodies->frozen = (bool*) (block + offsets[COLUMN_FROZEN]);
+    rigid_bodies->idle_frames = (size_t*) (block + offsets[COLUMN_IDLE_FRAMES]);
+    rigid_bodies->rest_positions = (Vec*) (block + offsets[COLUMN_REST_POSITIONS]);
+    rigid_bodies->islands = (size_t*) (block + offsets[COLUMN_ISLANDS]);
+    rigid_bodies->restless = (bool*) (block + offsets[COLUMN_RESTLESS]);
+    rigid_bodies->island_offsets = (size_t*) (block + offsets[COLUMN_ISLAND_OFFSETS]);
+    rigid_bodies->island_begins = (size_t*) (block + offsets[COLUMN_ISLAND_BEGINS]);
+    rigid_bodies->island_iterations = (size_t*) (block + offsets[COLUMN_ISLAND_ITERATIONS]);
+}
+
 RigidBodies *create_rigid_bodies(size_t capacity)
 {
+    trace_assert(capacity > 0);
+
     Lt *lt = create_lt();
     if (lt == NULL) {
         return NULL;
@@ -47,50 +254,82 @@ RigidBodies *create_rigid_bodies(size_t capacity)
     rigid_bodies->capacity = capacity;
     rigid_bodies->count = 0;
 
-    rigid_bodies->bodies = PUSH_LT(lt, nth_calloc(capacity, sizeof(Rect)), free);
-    if (rigid_bodies->bodies == NULL) {
+    size_t offsets[COLUMN_N];
+    char *block = PUSH_LT(
+        lt,
+        nth_calloc(1, rigid_bodies_block_layout(capacity, offsets)),
+        free);
+    if (block == NULL) {
         RETURN_LT(lt, NULL);
     }
+    rigid_bodies_bind_block(rigid_bodies, block, offsets);
 
-    rigid_bodies->velocities = PUSH_LT(lt, nth_calloc(capacity, sizeof(Vec)), free);
-    if (rigid_bodies->velocities == NULL) {
+    rigid_bodies->contacts_capacity = capacity;
+    rigid_bodies->contacts = PUSH_LT(lt, nth_calloc(capacity, sizeof(Contact)), free);
+    if (rigid_bodies->contacts == NULL) {
         RETURN_LT(lt, NULL);
     }
+    rigid_bodies->solver_iterations = RIGID_BODIES_SOLVER_ITERATIONS;
 
-    rigid_bodies->movements = PUSH_LT(lt, nth_calloc(capacity, sizeof(Vec)), free);
-    if (rigid_bodies->movements == NULL) {
+    rigid_bodies->island_contacts_capacity = capacity;
+    rigid_bodies->island_contacts = PUSH_LT(lt, nth_calloc(capacity, sizeof(Contact)), free);
+    if (rigid_bodies->island_contacts == NULL) {
         RETURN_LT(lt, NULL);
     }
 
-    rigid_bodies->colors = PUSH_LT(lt, nth_calloc(capacity, sizeof(Color)), free);
-    if (rigid_bodies->colors == NULL) {
-        RETURN_LT(lt, NULL);
-    }
+    rigid_bodies->query_tree = NULL;
+    rigid_bodies->query_tree_stale = true;
+    rigid_bodies->query_tree_moved = false;
+    rigid_bodies->query_tree_refits = 0;
+
+    memset(&rigid_bodies->stats, 0, sizeof(rigid_bodies->stats));
 
-    rigid_bodies->grounded = PUSH_LT(lt, nth_calloc(capacity, sizeof(bool)), free);
-    if (rigid_bodies->grounded == NULL) {
+    rigid_bodies->broadphase = RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE;
+    rigid_bodies->grid = PUSH_LT(
+        lt,
+        create_spatial_grid(RIGID_BODIES_GRID_CELL_SIZE),
+        destroy_spatial_grid);
+    if (rigid_bodies->grid == NULL) {
         RETURN_LT(lt, NULL);
     }
 
-    rigid_bodies->forces = PUSH_LT(lt, nth_calloc(capacity, sizeof(Vec)), free);
-    if (rigid_bodies->forces == NULL) {
+    rigid_bodies->sweep_and_prune = PUSH_LT(
+        lt,
+        create_sweep_and_prune(),
+        destroy_sweep_and_prune);
+    if (rigid_bodies->sweep_and_prune == NULL) {
         RETURN_LT(lt, NULL);
     }
 
-    rigid_bodies->deleted = PUSH_LT(lt, nth_calloc(capacity, sizeof(bool)), free);
-    if (rigid_bodies->deleted == NULL) {
-        RETURN_LT(lt, NULL);
+    return rigid_bodies;
+}
+
+// Moves all of the columns into a bigger block
+static int rigid_bodies_grow(RigidBodies *rigid_bodies, size_t capacity)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(capacity > rigid_bodies->capacity);
+
+    size_t old_offsets[COLUMN_N];
+    size_t new_offsets[COLUMN_N];
+    rigid_bodies_block_layout(rigid_bodies->capacity, old_offsets);
+
+    char *block = nth_calloc(1, rigid_bodies_block_layout(capacity, new_offsets));
+    if (block == NULL) {
+        return -1;
     }
 
-    rigid_bodies->collided = PUSH_LT(
-        lt,
-        create_hashset(sizeof(size_t) * 2, capacity * 2),
-        destroy_hashset);
-    if (rigid_bodies->collided == NULL) {
-        RETURN_LT(lt, NULL);
+    for (size_t column = 0; column < COLUMN_N; ++column) {
+        memcpy(block + new_offsets[column],
+               rigid_bodies->block + old_offsets[column],
+               column_sizes[column] * rigid_bodies->capacity);
     }
 
-    return rigid_bodies;
+    RESET_LT(rigid_bodies->lt, rigid_bodies->block, block);
+    rigid_bodies_bind_block(rigid_bodies, block, new_offsets);
+    rigid_bodies->capacity = capacity;
+
+    return 0;
 }
 
 void destroy_rigid_bodies(RigidBodies *rigid_bodies)
@@ -99,89 +338,467 @@ void destroy_rigid_bodies(RigidBodies *rigid_bodies)
     RETURN_LT0(rigid_bodies->lt);
 }
 
-static int rigid_bodies_collide_with_itself(RigidBodies *rigid_bodies)
+static size_t rigid_bodies_id_index(RigidBodyId id)
+{
+    return id & RIGID_BODIES_ID_INDEX_MASK;
+}
+
+static size_t rigid_bodies_id_generation(RigidBodyId id)
+{
+    return id >> RIGID_BODIES_ID_INDEX_BITS;
+}
+
+int rigid_bodies_is_alive(const RigidBodies *rigid_bodies,
+                          RigidBodyId id)
 {
     trace_assert(rigid_bodies);
 
-    if (rigid_bodies->count == 0) {
-        return 0;
+    const size_t index = rigid_bodies_id_index(id);
+    return index < rigid_bodies->ids_count
+        && rigid_bodies->generations[index] == rigid_bodies_id_generation(id)
+        && rigid_bodies->slots[index] != RIGID_BODIES_NO_SLOT;
+}
+
+static size_t rigid_bodies_slot(const RigidBodies *rigid_bodies,
+                                RigidBodyId id)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(rigid_bodies_is_alive(rigid_bodies, id));
+
+    const size_t slot = rigid_bodies->slots[rigid_bodies_id_index(id)];
+    trace_assert(slot < rigid_bodies->count);
+
+    return slot;
+}
+
+static void rigid_bodies_wake_up(RigidBodies *rigid_bodies, size_t i)
+{
+    trace_assert(rigid_bodies);
+
+    if (rigid_bodies->asleep[i]) {
+        rigid_bodies->asleep[i] = false;
+        rigid_bodies->idle_frames[i] = 0;
     }
+}
 
-    size_t pair[2];
-    hashset_clear(rigid_bodies->collided);
+static void rigid_bodies_push_force(RigidBodies *rigid_bodies,
+                                    size_t i,
+                                    Vec force)
+{
+    trace_assert(rigid_bodies);
+
+    if (force.x != 0.0f || force.y != 0.0f) {
+        rigid_bodies_wake_up(rigid_bodies, i);
+    }
 
-    bool the_variable_that_gets_set_when_a_collision_happens_xd = true;
+    rigid_bodies->forces[i] = vec_sum(rigid_bodies->forces[i], force);
+}
+
+static void rigid_bodies_push_damper(RigidBodies *rigid_bodies,
+                                     size_t i,
+                                     Vec v)
+{
+    trace_assert(rigid_bodies);
 
-    for (size_t i = 0; i < 1000 && the_variable_that_gets_set_when_a_collision_happens_xd; ++i) {
-        the_variable_that_gets_set_when_a_collision_happens_xd = false;
-        for (size_t i1 = 0; i1 < rigid_bodies->count - 1; ++i1) {
-            if (rigid_bodies->deleted[i1]) {
+    rigid_bodies_push_force(
+        rigid_bodies, i,
+        vec(
+            rigid_bodies->velocities[i].x * v.x,
+            rigid_bodies->velocities[i].y * v.y));
+}
+
+static bool rigid_bodies_collide_pair(RigidBodies *rigid_bodies,
+                                      Contact *contact)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(contact);
+
+    const size_t i1 = contact->i1;
+    const size_t i2 = contact->i2;
+
+    if (rigid_bodies->asleep[i1] && rigid_bodies->asleep[i2]) {
+        return false;
+    }
+
+    if (!rects_overlap(rigid_bodies->bodies[i1], rigid_bodies->bodies[i2])) {
+        return false;
+    }
+
+    // Something bumped into a sleeping body
+    rigid_bodies_wake_up(rigid_bodies, i1);
+    rigid_bodies_wake_up(rigid_bodies, i2);
+
+    contact->collided = true;
+
+    Vec orient = rect_impulse(&rigid_bodies->bodies[i1], &rigid_bodies->bodies[i2]);
+
+    if (orient.x > orient.y) {
+        if (rigid_bodies->bodies[i1].y < rigid_bodies->bodies[i2].y) {
+            rigid_bodies->grounded[i1] = true;
+        } else {
+            rigid_bodies->grounded[i2] = true;
+        }
+    }
+
+    rigid_bodies->velocities[i1] = vec(rigid_bodies->velocities[i1].x * orient.x, rigid_bodies->velocities[i1].y * orient.y);
+    rigid_bodies->velocities[i2] = vec(rigid_bodies->velocities[i2].x * orient.x, rigid_bodies->velocities[i2].y * orient.y);
+    rigid_bodies->movements[i1] = vec(rigid_bodies->movements[i1].x * orient.x, rigid_bodies->movements[i1].y * orient.y);
+    rigid_bodies->movements[i2] = vec(rigid_bodies->movements[i2].x * orient.x, rigid_bodies->movements[i2].y * orient.y);
+
+    return true;
+}
+
+typedef int (*RigidBodiesPairVisit)(RigidBodies *rigid_bodies, size_t i1, size_t i2);
+
+static int rigid_bodies_visit_pairs_brute_force(RigidBodies *rigid_bodies,
+                                                float margin,
+                                                RigidBodiesPairVisit visit)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(visit);
+
+    for (size_t i1 = 0; i1 + 1 < rigid_bodies->count; ++i1) {
+        if (rigid_bodies->deleted[i1]) {
+            continue;
+        }
+
+        const Rect r1 = rect(rigid_bodies->bodies[i1].x - margin,
+                             rigid_bodies->bodies[i1].y - margin,
+                             rigid_bodies->bodies[i1].w + margin * 2.0f,
+                             rigid_bodies->bodies[i1].h + margin * 2.0f);
+
+        for (size_t i2 = i1 + 1; i2 < rigid_bodies->count; ++i2) {
+            if (rigid_bodies->deleted[i2] ||
+                (rigid_bodies->asleep[i1] && rigid_bodies->asleep[i2]) ||
+                !rects_overlap(r1, rigid_bodies->bodies[i2])) {
                 continue;
             }
 
-            for (size_t i2 = i1 + 1; i2 < rigid_bodies->count; ++i2) {
-                if (rigid_bodies->deleted[i2]) {
-                    continue;
-                }
+            if (visit(rigid_bodies, i1, i2) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
 
-                if (!rects_overlap(rigid_bodies->bodies[i1], rigid_bodies->bodies[i2])) {
-                    continue;
-                }
+/* Calls visit for every pair of live bodies that are closer than
+ * margin to each other, except the pairs of two sleeping bodies.
+ * Stops with -1 as soon as visit fails. */
+static int rigid_bodies_visit_pairs(RigidBodies *rigid_bodies,
+                                    float margin,
+                                    RigidBodiesPairVisit visit)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(visit);
+
+    const size_t *pairs = NULL;
+    size_t pairs_count = 0;
+
+    switch (rigid_bodies->broadphase) {
+    case RIGID_BODIES_BROADPHASE_GRID:
+        if (spatial_grid_find_pairs(
+                rigid_bodies->grid,
+                rigid_bodies->bodies,
+                rigid_bodies->deleted,
+                rigid_bodies->asleep,
+                rigid_bodies->count,
+                margin,
+                &pairs, &pairs_count) < 0) {
+            return -1;
+        }
+        break;
+
+    case RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE:
+        if (sweep_and_prune_find_pairs(
+                rigid_bodies->sweep_and_prune,
+                rigid_bodies->bodies,
+                rigid_bodies->deleted,
+                rigid_bodies->asleep,
+                rigid_bodies->count,
+                margin,
+                &pairs, &pairs_count) < 0) {
+            return -1;
+        }
+        break;
 
-                the_variable_that_gets_set_when_a_collision_happens_xd = true;
+    case RIGID_BODIES_BROADPHASE_BRUTE_FORCE:
+    case RIGID_BODIES_BROADPHASE_N:
+        return rigid_bodies_visit_pairs_brute_force(rigid_bodies, margin, visit);
+    }
 
-                pair[0] = i1;
-                pair[1] = i2;
-                hashset_insert(rigid_bodies->collided, pair);
+    for (size_t i = 0; i < pairs_count; ++i) {
+        if (visit(rigid_bodies, pairs[i * 2], pairs[i * 2 + 1]) < 0) {
+            return -1;
+        }
+    }
 
-                Vec orient = rect_impulse(&rigid_bodies->bodies[i1], &rigid_bodies->bodies[i2]);
+    return 0;
+}
 
-                if (orient.x > orient.y) {
-                    if (rigid_bodies->bodies[i1].y < rigid_bodies->bodies[i2].y) {
-                        rigid_bodies->grounded[i1] = true;
-                    } else {
-                        rigid_bodies->grounded[i2] = true;
-                    }
-                }
+static int rigid_bodies_push_contact(RigidBodies *rigid_bodies,
+                                     size_t i1, size_t i2)
+{
+    trace_assert(rigid_bodies);
 
-                rigid_bodies->velocities[i1] = vec(rigid_bodies->velocities[i1].x * orient.x, rigid_bodies->velocities[i1].y * orient.y);
-                rigid_bodies->velocities[i2] = vec(rigid_bodies->velocities[i2].x * orient.x, rigid_bodies->velocities[i2].y * orient.y);
-                rigid_bodies->movements[i1] = vec(rigid_bodies->movements[i1].x * orient.x, rigid_bodies->movements[i1].y * orient.y);
-                rigid_bodies->movements[i2] = vec(rigid_bodies->movements[i2].x * orient.x, rigid_bodies->movements[i2].y * orient.y);
+    if (rigid_bodies->contacts_count >= rigid_bodies->contacts_capacity) {
+        Contact *new_contacts = nth_realloc(
+            rigid_bodies->contacts,
+            sizeof(Contact) * rigid_bodies->contacts_capacity * 2);
+        if (new_contacts == NULL) {
+            return -1;
+        }
 
-            }
+        rigid_bodies->contacts = REPLACE_LT(rigid_bodies->lt, rigid_bodies->contacts, new_contacts);
+        rigid_bodies->contacts_capacity *= 2;
+    }
+
+    Contact *contact = &rigid_bodies->contacts[rigid_bodies->contacts_count++];
+    contact->i1 = i1;
+    contact->i2 = i2;
+    contact->collided = false;
+
+    return 0;
+}
+
+/* Returns how many passes over the contacts it took */
+static size_t rigid_bodies_solve_contacts(RigidBodies *rigid_bodies,
+                                          Contact *contacts,
+                                          size_t contacts_count)
+{
+    trace_assert(rigid_bodies);
+
+    bool collided = true;
+    size_t k = 0;
+    for (; k < rigid_bodies->solver_iterations && collided; ++k) {
+        collided = false;
+        for (size_t i = 0; i < contacts_count; ++i) {
+            collided = rigid_bodies_collide_pair(rigid_bodies, &contacts[i]) || collided;
         }
     }
 
-    size_t *collided = hashset_values(rigid_bodies->collided);
-    const size_t n = hashset_count(rigid_bodies->collided);
-    for (size_t i = 0; i < n; ++i) {
-        const size_t i1 = *(collided + i * 2);
-        const size_t i2 = *(collided + i * 2 + 1);
+    for (size_t i = 0; i < contacts_count; ++i) {
+        if (!contacts[i].collided) {
+            continue;
+        }
+
+        const size_t i1 = contacts[i].i1;
+        const size_t i2 = contacts[i].i2;
 
-        rigid_bodies_apply_force(
+        rigid_bodies_push_force(
             rigid_bodies, i1, vec_sum(rigid_bodies->velocities[i2], rigid_bodies->movements[i2]));
-        rigid_bodies_apply_force(
+        rigid_bodies_push_force(
             rigid_bodies, i2, vec_sum(rigid_bodies->velocities[i1], rigid_bodies->movements[i1]));
     }
 
+    return k;
+}
+
+static size_t rigid_bodies_count_collisions(const Contact *contacts,
+                                            size_t contacts_count)
+{
+    size_t collisions = 0;
+    for (size_t i = 0; i < contacts_count; ++i) {
+        collisions += contacts[i].collided;
+    }
+    return collisions;
+}
+
+static size_t rigid_bodies_island(RigidBodies *rigid_bodies, size_t i)
+{
+    trace_assert(rigid_bodies);
+
+    while (rigid_bodies->islands[i] != i) {
+        rigid_bodies->islands[i] = rigid_bodies->islands[rigid_bodies->islands[i]];
+        i = rigid_bodies->islands[i];
+    }
+
+    return i;
+}
+
+static void rigid_bodies_join_islands(RigidBodies *rigid_bodies,
+                                      size_t i1, size_t i2)
+{
+    trace_assert(rigid_bodies);
+
+    const size_t island1 = rigid_bodies_island(rigid_bodies, i1);
+    const size_t island2 = rigid_bodies_island(rigid_bodies, i2);
+
+    if (island1 < island2) {
+        rigid_bodies->islands[island2] = island1;
+    } else {
+        rigid_bodies->islands[island1] = island2;
+    }
+}
+
+static void rigid_bodies_solve_island(void *param, size_t island)
+{
+    RigidBodies *rigid_bodies = param;
+    trace_assert(rigid_bodies);
+    trace_assert(island < rigid_bodies->islands_count);
+
+    const size_t begin = rigid_bodies->island_begins[island];
+    const size_t end = rigid_bodies->island_begins[island + 1];
+
+    rigid_bodies->island_iterations[island] = rigid_bodies_solve_contacts(
+        rigid_bodies,
+        rigid_bodies->island_contacts + begin,
+        end - begin);
+}
+
+/* The contacts of different islands share no bodies, so the islands
+ * are solved on their own, by the workers in parallel if there are
+ * any. Within an island the contacts keep their order and every
+ * island is solved the same way with or without the workers, so the
+ * result and the stats do not depend on the number of threads. An
+ * island that settles stops early instead of being passed over until
+ * the last one settles. */
+static int rigid_bodies_solve_islands(RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    const Contact *const contacts = rigid_bodies->contacts;
+    const size_t contacts_count = rigid_bodies->contacts_count;
+
+    if (rigid_bodies->island_contacts_capacity < contacts_count) {
+        Contact *island_contacts = nth_realloc(
+            rigid_bodies->island_contacts,
+            sizeof(Contact) * rigid_bodies->contacts_capacity);
+        if (island_contacts == NULL) {
+            return -1;
+        }
+
+        rigid_bodies->island_contacts = REPLACE_LT(
+            rigid_bodies->lt,
+            rigid_bodies->island_contacts,
+            island_contacts);
+        rigid_bodies->island_contacts_capacity = rigid_bodies->contacts_capacity;
+    }
+
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        rigid_bodies->islands[i] = i;
+        rigid_bodies->island_offsets[i] = 0;
+    }
+
+    for (size_t i = 0; i < contacts_count; ++i) {
+        rigid_bodies_join_islands(rigid_bodies, contacts[i].i1, contacts[i].i2);
+    }
+
+    for (size_t i = 0; i < contacts_count; ++i) {
+        rigid_bodies->island_offsets[rigid_bodies_island(rigid_bodies, contacts[i].i1)]++;
+    }
+
+    // A counting sort of the contacts by their islands that keeps the
+    // order of the contacts within an island
+    size_t begin = 0;
+    rigid_bodies->islands_count = 0;
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        const size_t size = rigid_bodies->island_offsets[i];
+        if (size > 0) {
+            rigid_bodies->island_begins[rigid_bodies->islands_count++] = begin;
+            rigid_bodies->island_offsets[i] = begin;
+            begin += size;
+        }
+    }
+    rigid_bodies->island_begins[rigid_bodies->islands_count] = begin;
+
+    for (size_t i = 0; i < contacts_count; ++i) {
+        const size_t island = rigid_bodies_island(rigid_bodies, contacts[i].i1);
+        rigid_bodies->island_contacts[rigid_bodies->island_offsets[island]++] = contacts[i];
+    }
+
+    if (rigid_bodies->workers != NULL) {
+        worker_pool_run(
+            rigid_bodies->workers,
+            rigid_bodies_solve_island,
+            rigid_bodies,
+            rigid_bodies->islands_count);
+    } else {
+        for (size_t i = 0; i < rigid_bodies->islands_count; ++i) {
+            rigid_bodies_solve_island(rigid_bodies, i);
+        }
+    }
+
+    for (size_t i = 0; i < rigid_bodies->islands_count; ++i) {
+        rigid_bodies->stats.solver_iterations += rigid_bodies->island_iterations[i];
+    }
+    rigid_bodies->stats.collisions = rigid_bodies_count_collisions(
+        rigid_bodies->island_contacts, contacts_count);
+
     return 0;
 }
 
-static int rigid_bodies_collide_with_platforms(
+/* The contacts are gathered once per step, with a margin for the
+ * bodies that get pushed into each other while the contacts are
+ * being solved. Then the solver goes through only those contacts at
+ * most solver_iterations times, so the cost of a step is bounded by
+ * the number of contacts. */
+static int rigid_bodies_collide_with_itself(RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    memset(&rigid_bodies->stats, 0, sizeof(rigid_bodies->stats));
+    rigid_bodies->contacts_count = 0;
+
+    if (rigid_bodies->count == 0) {
+        return 0;
+    }
+
+    if (rigid_bodies_visit_pairs(
+            rigid_bodies,
+            RIGID_BODIES_SPECULATIVE_MARGIN,
+            rigid_bodies_push_contact) < 0) {
+        return -1;
+    }
+
+    rigid_bodies->stats.contacts = rigid_bodies->contacts_count;
+
+    return rigid_bodies_solve_islands(rigid_bodies);
+}
+
+static void rigid_bodies_collide_range_with_platforms(
     RigidBodies *rigid_bodies,
-    const Platforms *platforms)
+    const Platforms *platforms,
+    size_t begin, size_t end)
 {
     trace_assert(rigid_bodies);
     trace_assert(platforms);
+    trace_assert(end <= rigid_bodies->count);
 
     int sides[RECT_SIDE_N] = { 0, 0, 0, 0 };
 
-    for (size_t i = 0; i < rigid_bodies->count; ++i) {
-        if (rigid_bodies->deleted[i]) {
+    for (size_t i = begin; i < end; ++i) {
+        if (rigid_bodies->deleted[i] || rigid_bodies->asleep[i]) {
             continue;
         }
 
+        // A body that moved further than its own size during the step
+        // could have tunneled through a thin platform, so it is swept
+        // from where it was before the step
+        const Vec displacement = vec_sub(
+            vec(rigid_bodies->bodies[i].x, rigid_bodies->bodies[i].y),
+            rigid_bodies->previous_positions[i]);
+        if (fabsf(displacement.x) > rigid_bodies->bodies[i].w ||
+            fabsf(displacement.y) > rigid_bodies->bodies[i].h) {
+            Rect swept = rect_from_vecs(
+                rigid_bodies->previous_positions[i],
+                vec(rigid_bodies->bodies[i].w, rigid_bodies->bodies[i].h));
+            const Vec v = platforms_sweep_rect(platforms, &swept, displacement);
+
+            if (v.x == 0.0f || v.y == 0.0f) {
+                rigid_bodies->bodies[i] = swept;
+                rigid_bodies->velocities[i] = vec_entry_mult(rigid_bodies->velocities[i], v);
+                rigid_bodies->movements[i] = vec_entry_mult(rigid_bodies->movements[i], v);
+            }
+
+            // The sweep leaves the body flush with the platform, which
+            // platforms_touches_rect_sides does not count as touching
+            if (v.y == 0.0f && displacement.y > 0.0f) {
+                rigid_bodies->grounded[i] = true;
+            }
+        }
+
         memset(sides, 0, sizeof(int) * RECT_SIDE_N);
 
         platforms_touches_rect_sides(platforms, rigid_bodies->bodies[i], sides);
@@ -193,119 +810,275 @@ static int rigid_bodies_collide_with_platforms(
         Vec v = platforms_snap_rect(platforms, &rigid_bodies->bodies[i]);
         rigid_bodies->velocities[i] = vec_entry_mult(rigid_bodies->velocities[i], v);
         rigid_bodies->movements[i] = vec_entry_mult(rigid_bodies->movements[i], v);
-        rigid_bodies_damper(rigid_bodies, i, vec_entry_mult(v, vec(-16.0f, 0.0f)));
+        rigid_bodies_push_damper(rigid_bodies, i, vec_entry_mult(v, vec(-16.0f, 0.0f)));
     }
+}
 
-    return 0;
+typedef struct {
+    RigidBodies *rigid_bodies;
+    const Platforms *platforms;
+} RigidBodiesPlatformsJob;
+
+typedef struct {
+    RigidBodies *rigid_bodies;
+    float delta_time;
+} RigidBodiesIntegrateJob;
+
+static size_t rigid_bodies_chunks_count(const RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+    return (rigid_bodies->count + RIGID_BODIES_CHUNK_SIZE - 1) / RIGID_BODIES_CHUNK_SIZE;
 }
 
-int rigid_bodies_collide(RigidBodies *rigid_bodies,
-                         const Platforms *platforms)
+static size_t rigid_bodies_chunk_end(const RigidBodies *rigid_bodies, size_t chunk)
 {
-    // TODO(#683): RigidBodies should collide only the bodies that were updated on after a previous collision
-    memset(rigid_bodies->grounded, 0, sizeof(bool) * rigid_bodies->count);
+    trace_assert(rigid_bodies);
+    const size_t end = (chunk + 1) * RIGID_BODIES_CHUNK_SIZE;
+    return end < rigid_bodies->count ? end : rigid_bodies->count;
+}
 
-    if (rigid_bodies_collide_with_itself(rigid_bodies) < 0) {
-        return -1;
-    }
+static void rigid_bodies_collide_chunk_with_platforms(void *param, size_t chunk)
+{
+    RigidBodiesPlatformsJob *job = param;
+    trace_assert(job);
+
+    rigid_bodies_collide_range_with_platforms(
+        job->rigid_bodies,
+        job->platforms,
+        chunk * RIGID_BODIES_CHUNK_SIZE,
+        rigid_bodies_chunk_end(job->rigid_bodies, chunk));
+}
 
-    if (rigid_bodies_collide_with_platforms(rigid_bodies, platforms) < 0) {
-        return -1;
+// Every body is snapped to the platforms on its own, so the bodies
+// are split between the workers by chunks
+static int rigid_bodies_collide_with_platforms(
+    RigidBodies *rigid_bodies,
+    const Platforms *platforms)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(platforms);
+
+    if (rigid_bodies->workers == NULL) {
+        rigid_bodies_collide_range_with_platforms(
+            rigid_bodies, platforms, 0, rigid_bodies->count);
+        return 0;
     }
 
+    RigidBodiesPlatformsJob job = {
+        .rigid_bodies = rigid_bodies,
+        .platforms = platforms
+    };
+
+    worker_pool_run(
+        rigid_bodies->workers,
+        rigid_bodies_collide_chunk_with_platforms,
+        &job,
+        rigid_bodies_chunks_count(rigid_bodies));
+
     return 0;
 }
 
-int rigid_bodies_update(RigidBodies *rigid_bodies,
-                        RigidBodyId id,
-                        float delta_time)
+/* Bodies that touch each other form an island. The island falls
+ * asleep only when all of its bodies stayed still for
+ * RIGID_BODIES_SLEEP_FRAMES, and a sleeping body wakes up as soon
+ * as it ends up on the same island with a body that did not.
+ *
+ * The islands are made of the contacts of the step, so there are no
+ * pairs of two sleeping bodies among them. A sleeping body is woken
+ * up through its pair with an awake body, and the rest of its
+ * sleeping island follows one step later through the pairs of the
+ * body that just woke up. */
+static int rigid_bodies_update_sleep(RigidBodies *rigid_bodies)
 {
     trace_assert(rigid_bodies);
 
-    rigid_bodies->velocities[id] = vec_sum(
-            rigid_bodies->velocities[id],
-            vec_scala_mult(
-                rigid_bodies->forces[id],
-                delta_time));
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        if (rigid_bodies->deleted[i] || rigid_bodies->asleep[i]) {
+            continue;
+        }
 
-    Vec position = vec(rigid_bodies->bodies[id].x,
-                       rigid_bodies->bodies[id].y);
+        const Vec position = vec(rigid_bodies->bodies[i].x, rigid_bodies->bodies[i].y);
+        const float distance = vec_length(vec_sub(position, rigid_bodies->rest_positions[i]));
+        rigid_bodies->rest_positions[i] = position;
+
+        if (distance < RIGID_BODIES_SLEEP_DISTANCE &&
+            vec_length(rigid_bodies->velocities[i]) < RIGID_BODIES_SLEEP_VELOCITY &&
+            vec_length(rigid_bodies->forces[i]) < RIGID_BODIES_SLEEP_FORCE &&
+            rigid_bodies->movements[i].x == 0.0f &&
+            rigid_bodies->movements[i].y == 0.0f) {
+            rigid_bodies->idle_frames[i]++;
+        } else {
+            rigid_bodies->idle_frames[i] = 0;
+        }
+    }
 
-    position = vec_sum(
-        position,
-        vec_scala_mult(
-            vec_sum(
-                rigid_bodies->velocities[id],
-                rigid_bodies->movements[id]),
-            delta_time));
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        rigid_bodies->islands[i] = i;
+        rigid_bodies->restless[i] = false;
+    }
+
+    // The contacts were gathered with a bigger margin before the
+    // bodies were pushed apart, so only the ones that still touch
+    // join the islands
+    for (size_t i = 0; i < rigid_bodies->contacts_count; ++i) {
+        const size_t i1 = rigid_bodies->contacts[i].i1;
+        const size_t i2 = rigid_bodies->contacts[i].i2;
+        const Rect r1 = rect(rigid_bodies->bodies[i1].x - RIGID_BODIES_CONTACT_MARGIN,
+                             rigid_bodies->bodies[i1].y - RIGID_BODIES_CONTACT_MARGIN,
+                             rigid_bodies->bodies[i1].w + RIGID_BODIES_CONTACT_MARGIN * 2.0f,
+                             rigid_bodies->bodies[i1].h + RIGID_BODIES_CONTACT_MARGIN * 2.0f);
+
+        if (rects_overlap(r1, rigid_bodies->bodies[i2])) {
+            rigid_bodies_join_islands(rigid_bodies, i1, i2);
+        }
+    }
 
-    rigid_bodies->bodies[id].x = position.x;
-    rigid_bodies->bodies[id].y = position.y;
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        if (!rigid_bodies->deleted[i] &&
+            !rigid_bodies->asleep[i] &&
+            rigid_bodies->idle_frames[i] < RIGID_BODIES_SLEEP_FRAMES) {
+            rigid_bodies->restless[rigid_bodies_island(rigid_bodies, i)] = true;
+        }
+    }
 
-    rigid_bodies->forces[id] = vec(0.0f, 0.0f);
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        if (rigid_bodies->deleted[i]) {
+            continue;
+        }
+
+        if (rigid_bodies->restless[rigid_bodies_island(rigid_bodies, i)]) {
+            if (rigid_bodies->asleep[i]) {
+                rigid_bodies_wake_up(rigid_bodies, i);
+            }
+        } else if (!rigid_bodies->asleep[i]) {
+            rigid_bodies->asleep[i] = true;
+            rigid_bodies->velocities[i] = vec(0.0f, 0.0f);
+            rigid_bodies->forces[i] = vec(0.0f, 0.0f);
+        }
+    }
 
     return 0;
 }
 
-int rigid_bodies_render(RigidBodies *rigid_bodies,
-                        RigidBodyId id,
-                        Camera *camera)
+int rigid_bodies_collide(RigidBodies *rigid_bodies,
+                         const Platforms *platforms)
 {
     trace_assert(rigid_bodies);
-    trace_assert(camera);
+    trace_assert(platforms);
 
-    char text_buffer[256];
+    if (rigid_bodies->deleted_count > 0 &&
+        rigid_bodies->deleted_count * RIGID_BODIES_COMPACT_RATIO >= rigid_bodies->count) {
+        rigid_bodies_compact(rigid_bodies);
+    }
 
-    if (camera_fill_rect(
-            camera,
-            rigid_bodies->bodies[id],
-            rigid_bodies->colors[id]) < 0) {
-        return -1;
+    bool awake = false;
+
+    // Sleeping bodies keep their ground from the moment they fell asleep
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        rigid_bodies->grounded[i] = rigid_bodies->grounded[i] && rigid_bodies->asleep[i];
+        awake = awake || (!rigid_bodies->deleted[i] && !rigid_bodies->asleep[i]);
     }
 
-    snprintf(text_buffer, 256, "id: %ld", id);
+    if (!awake) {
+        // Nothing moves, so the stats of the last awake step must
+        // not be reported again
+        memset(&rigid_bodies->stats, 0, sizeof(rigid_bodies->stats));
+        rigid_bodies->contacts_count = 0;
+        return 0;
+    }
 
-    if (camera_render_debug_text(
-            camera,
-            text_buffer,
-            vec(rigid_bodies->bodies[id].x,
-                rigid_bodies->bodies[id].y)) < 0) {
+    rigid_bodies->query_tree_moved = true;
+
+    if (rigid_bodies_collide_with_itself(rigid_bodies) < 0) {
         return -1;
     }
 
-    snprintf(text_buffer, 256, "p:(%.2f, %.2f)",
-             rigid_bodies->bodies[id].x,
-             rigid_bodies->bodies[id].y);
-    if (camera_render_debug_text(
-            camera,
-            text_buffer,
-            vec(rigid_bodies->bodies[id].x,
-                rigid_bodies->bodies[id].y + FONT_CHAR_HEIGHT * 2.0f))) {
+    if (rigid_bodies_collide_with_platforms(rigid_bodies, platforms) < 0) {
         return -1;
     }
 
-    snprintf(text_buffer, 256, "v:(%.2f, %.2f)",
-             rigid_bodies->velocities[id].x,
-             rigid_bodies->velocities[id].y);
-    if (camera_render_debug_text(
-            camera,
-            text_buffer,
-            vec(rigid_bodies->bodies[id].x,
-                rigid_bodies->bodies[id].y + FONT_CHAR_HEIGHT * 4.0f))) {
+    if (rigid_bodies_update_sleep(rigid_bodies) < 0) {
         return -1;
     }
 
-    snprintf(text_buffer, 256, "m:(%.2f, %.2f)",
-             rigid_bodies->movements[id].x,
-             rigid_bodies->movements[id].y);
-    if (camera_render_debug_text(
-            camera,
-            text_buffer,
-            vec(rigid_bodies->bodies[id].x,
-                rigid_bodies->bodies[id].y + FONT_CHAR_HEIGHT * 6.0f))) {
-        return -1;
+    return 0;
+}
+
+static void rigid_bodies_integrate(RigidBodies *rigid_bodies,
+                                   size_t begin, size_t end,
+                                   float delta_time)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(end <= rigid_bodies->count);
+
+    Rect *const restrict bodies = rigid_bodies->bodies;
+    Vec *const restrict previous_positions = rigid_bodies->previous_positions;
+    Vec *const restrict velocities = rigid_bodies->velocities;
+    const Vec *const restrict movements = rigid_bodies->movements;
+    Vec *const restrict forces = rigid_bodies->forces;
+    const bool *const restrict deleted = rigid_bodies->deleted;
+    const bool *const restrict asleep = rigid_bodies->asleep;
+    const bool *const restrict frozen = rigid_bodies->frozen;
+
+    for (size_t i = begin; i < end; ++i) {
+        // Bodies that must stay in place get the zero time step
+        // instead of a branch, so the loop can be vectorized
+        const float dt = (float) (1 - (deleted[i] | asleep[i] | frozen[i])) * delta_time;
+
+        previous_positions[i].x = bodies[i].x;
+        previous_positions[i].y = bodies[i].y;
+        velocities[i].x += forces[i].x * dt;
+        velocities[i].y += forces[i].y * dt;
+        bodies[i].x += (velocities[i].x + movements[i].x) * dt;
+        bodies[i].y += (velocities[i].y + movements[i].y) * dt;
+        forces[i].x = 0.0f;
+        forces[i].y = 0.0f;
     }
+}
+
+static void rigid_bodies_integrate_chunk(void *param, size_t chunk)
+{
+    RigidBodiesIntegrateJob *job = param;
+    trace_assert(job);
+
+    rigid_bodies_integrate(
+        job->rigid_bodies,
+        chunk * RIGID_BODIES_CHUNK_SIZE,
+        rigid_bodies_chunk_end(job->rigid_bodies, chunk),
+        job->delta_time);
+}
+
+void rigid_bodies_integrate_all(RigidBodies *rigid_bodies,
+                                float delta_time)
+{
+    trace_assert(rigid_bodies);
+
+    rigid_bodies->query_tree_moved = true;
+
+    if (rigid_bodies->workers == NULL) {
+        rigid_bodies_integrate(rigid_bodies, 0, rigid_bodies->count, delta_time);
+        return;
+    }
+
+    RigidBodiesIntegrateJob job = {
+        .rigid_bodies = rigid_bodies,
+        .delta_time = delta_time
+    };
+
+    worker_pool_run(
+        rigid_bodies->workers,
+        rigid_bodies_integrate_chunk,
+        &job,
+        rigid_bodies_chunks_count(rigid_bodies));
+}
 
+int rigid_bodies_update(RigidBodies *rigid_bodies,
+                        RigidBodyId id,
+                        float delta_time)
+{
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+    rigid_bodies_integrate(rigid_bodies, slot, slot + 1, delta_time);
+    rigid_bodies->query_tree_moved = true;
     return 0;
 }
 
@@ -314,22 +1087,150 @@ RigidBodyId rigid_bodies_add(RigidBodies *rigid_bodies,
                              Color color)
 {
     trace_assert(rigid_bodies);
+
+    rigid_bodies->query_tree_stale = true;
+
+    if (rigid_bodies->count >= rigid_bodies->capacity && rigid_bodies->deleted_count > 0) {
+        rigid_bodies_compact(rigid_bodies);
+    }
+
+    // Running out of memory for the bodies is fatal, the callers have
+    // no way to go on without the body
+    if (rigid_bodies->count >= rigid_bodies->capacity) {
+        const int grown = rigid_bodies_grow(rigid_bodies, rigid_bodies->capacity * 2);
+        trace_assert(grown == 0);
+    }
+
     trace_assert(rigid_bodies->count < rigid_bodies->capacity);
 
-    RigidBodyId id = rigid_bodies->count++;
-    rigid_bodies->bodies[id] = rect;
-    rigid_bodies->colors[id] = color;
+    const size_t index = rigid_bodies->free_ids_count > 0
+        ? rigid_bodies->free_ids[--rigid_bodies->free_ids_count]
+        : rigid_bodies->ids_count++;
+    trace_assert(index <= RIGID_BODIES_ID_INDEX_MASK);
+    const RigidBodyId id = index | (rigid_bodies->generations[index] << RIGID_BODIES_ID_INDEX_BITS);
+    const size_t slot = rigid_bodies->count++;
+
+    rigid_bodies->slots[index] = slot;
+    rigid_bodies->ids[slot] = id;
+    rigid_bodies->epoch++;
+
+    rigid_bodies->bodies[slot] = rect;
+    rigid_bodies->previous_positions[slot] = vec(rect.x, rect.y);
+    rigid_bodies->velocities[slot] = vec(0.0f, 0.0f);
+    rigid_bodies->movements[slot] = vec(0.0f, 0.0f);
+    rigid_bodies->colors[slot] = color;
+    rigid_bodies->grounded[slot] = false;
+    rigid_bodies->forces[slot] = vec(0.0f, 0.0f);
+    rigid_bodies->deleted[slot] = false;
+    rigid_bodies->asleep[slot] = false;
+    rigid_bodies->frozen[slot] = false;
+    rigid_bodies->idle_frames[slot] = 0;
+    rigid_bodies->rest_positions[slot] = vec(rect.x, rect.y);
 
     return id;
 }
 
+static int rigid_bodies_update_query_tree(RigidBodies *rigid_bodies);
+
+typedef struct {
+    RigidBodies *rigid_bodies;
+    Rect area;
+} RigidBodiesWake;
+
+static int rigid_bodies_wake_visit(void *param, size_t slot)
+{
+    RigidBodiesWake *wake = param;
+    trace_assert(wake);
+
+    RigidBodies *rigid_bodies = wake->rigid_bodies;
+    if (!rigid_bodies->deleted[slot]
+        && rigid_bodies->asleep[slot]
+        && rects_overlap(wake->area, rigid_bodies->bodies[slot])) {
+        rigid_bodies_wake_up(rigid_bodies, slot);
+    }
+
+    return 0;
+}
+
 void rigid_bodies_remove(RigidBodies *rigid_bodies,
                          RigidBodyId id)
 {
     trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->capacity);
 
-    rigid_bodies->deleted[id] = true;
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+    const Rect area = rect(rigid_bodies->bodies[slot].x - RIGID_BODIES_CONTACT_MARGIN,
+                           rigid_bodies->bodies[slot].y - RIGID_BODIES_CONTACT_MARGIN,
+                           rigid_bodies->bodies[slot].w + RIGID_BODIES_CONTACT_MARGIN * 2.0f,
+                           rigid_bodies->bodies[slot].h + RIGID_BODIES_CONTACT_MARGIN * 2.0f);
+
+    rigid_bodies->deleted[slot] = true;
+    rigid_bodies->deleted_count++;
+    const size_t index = rigid_bodies_id_index(id);
+    rigid_bodies->slots[index] = RIGID_BODIES_NO_SLOT;
+    rigid_bodies->generations[index] =
+        (rigid_bodies->generations[index] + 1) & RIGID_BODIES_ID_GENERATION_MASK;
+    rigid_bodies->free_ids[rigid_bodies->free_ids_count++] = index;
+    rigid_bodies->epoch++;
+
+    // Whatever was resting on the body should fall now. The query
+    // tree keeps removing many bodies from being quadratic, it is
+    // built at most once for all of them. Without the tree every
+    // body is checked.
+    RigidBodiesWake wake = {
+        .rigid_bodies = rigid_bodies,
+        .area = area
+    };
+    if (rigid_bodies_update_query_tree(rigid_bodies) == 0) {
+        aabb_tree_query(rigid_bodies->query_tree, area, rigid_bodies_wake_visit, &wake);
+        return;
+    }
+
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        if (rigid_bodies->asleep[i] && rects_overlap(area, rigid_bodies->bodies[i])) {
+            rigid_bodies_wake_up(rigid_bodies, i);
+        }
+    }
+}
+
+void rigid_bodies_compact(RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    rigid_bodies->query_tree_stale = true;
+
+    size_t n = 0;
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        if (rigid_bodies->deleted[i]) {
+            rigid_bodies->remap[i] = RIGID_BODIES_NO_SLOT;
+            continue;
+        }
+
+        rigid_bodies->remap[i] = n;
+
+        if (n != i) {
+            rigid_bodies->ids[n] = rigid_bodies->ids[i];
+            rigid_bodies->bodies[n] = rigid_bodies->bodies[i];
+            rigid_bodies->previous_positions[n] = rigid_bodies->previous_positions[i];
+            rigid_bodies->velocities[n] = rigid_bodies->velocities[i];
+            rigid_bodies->movements[n] = rigid_bodies->movements[i];
+            rigid_bodies->colors[n] = rigid_bodies->colors[i];
+            rigid_bodies->grounded[n] = rigid_bodies->grounded[i];
+            rigid_bodies->forces[n] = rigid_bodies->forces[i];
+            rigid_bodies->deleted[n] = false;
+            rigid_bodies->asleep[n] = rigid_bodies->asleep[i];
+            rigid_bodies->frozen[n] = rigid_bodies->frozen[i];
+            rigid_bodies->idle_frames[n] = rigid_bodies->idle_frames[i];
+            rigid_bodies->rest_positions[n] = rigid_bodies->rest_positions[i];
+            rigid_bodies->slots[rigid_bodies_id_index(rigid_bodies->ids[n])] = n;
+        }
+
+        n++;
+    }
+
+    sweep_and_prune_remap(rigid_bodies->sweep_and_prune, rigid_bodies->remap, n);
+
+    rigid_bodies->count = n;
+    rigid_bodies->deleted_count = 0;
 }
 
 RigidBodyId rigid_bodies_add_from_line_stream(RigidBodies *rigid_bodies,
@@ -359,37 +1260,105 @@ RigidBodyId rigid_bodies_add_from_line_stream(RigidBodies *rigid_bodies,
 
 Rect rigid_bodies_hitbox(const RigidBodies *rigid_bodies,
                          RigidBodyId id)
+{
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+
+    return rigid_bodies->bodies[slot];
+}
+
+void rigid_bodies_hitboxes(const RigidBodies *rigid_bodies,
+                           const RigidBodyId *ids,
+                           size_t count,
+                           Rect *hitboxes)
 {
     trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
+    trace_assert(ids || count == 0);
+    trace_assert(hitboxes || count == 0);
 
-    return rigid_bodies->bodies[id];
+    for (size_t i = 0; i < count; ++i) {
+        hitboxes[i] = rigid_bodies->bodies[rigid_bodies_slot(rigid_bodies, ids[i])];
+    }
+}
+
+Color rigid_bodies_color(const RigidBodies *rigid_bodies,
+                         RigidBodyId id)
+{
+    return rigid_bodies->colors[rigid_bodies_slot(rigid_bodies, id)];
+}
+
+Vec rigid_bodies_velocity(const RigidBodies *rigid_bodies,
+                          RigidBodyId id)
+{
+    return rigid_bodies->velocities[rigid_bodies_slot(rigid_bodies, id)];
+}
+
+Vec rigid_bodies_movement(const RigidBodies *rigid_bodies,
+                          RigidBodyId id)
+{
+    return rigid_bodies->movements[rigid_bodies_slot(rigid_bodies, id)];
+}
+
+Rect rigid_bodies_interpolated_hitbox(const RigidBodies *rigid_bodies,
+                                      RigidBodyId id,
+                                      float alpha)
+{
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+    const Rect body = rigid_bodies->bodies[slot];
+    const Vec previous = rigid_bodies->previous_positions[slot];
+
+    return rect(previous.x + (body.x - previous.x) * alpha,
+                previous.y + (body.y - previous.y) * alpha,
+                body.w, body.h);
 }
 
 void rigid_bodies_move(RigidBodies *rigid_bodies,
                        RigidBodyId id,
                        Vec movement)
 {
-    trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+
+    if (movement.x != 0.0f || movement.y != 0.0f) {
+        rigid_bodies_wake_up(rigid_bodies, slot);
+    }
 
-    rigid_bodies->movements[id] = movement;
+    rigid_bodies->movements[slot] = movement;
 }
 
 int rigid_bodies_touches_ground(const RigidBodies *rigid_bodies,
                                 RigidBodyId id)
 {
-    trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
 
-    return rigid_bodies->grounded[id];
+    return rigid_bodies->grounded[slot];
 }
 
 void rigid_bodies_apply_omniforce(RigidBodies *rigid_bodies,
                                   Vec force)
 {
+    trace_assert(rigid_bodies);
+
     for (size_t i = 0; i < rigid_bodies->count; ++i) {
-        rigid_bodies_apply_force(rigid_bodies, i, force);
+        if (!rigid_bodies->asleep[i]) {
+            rigid_bodies_push_force(rigid_bodies, i, force);
+        }
+    }
+}
+
+void rigid_bodies_apply_forces(RigidBodies *rigid_bodies,
+                               const RigidBodyId *ids,
+                               const Vec *forces,
+                               const Vec *dampers,
+                               size_t count)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(ids || count == 0);
+    trace_assert(forces || count == 0);
+    trace_assert(dampers || count == 0);
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t slot = rigid_bodies_slot(rigid_bodies, ids[i]);
+        rigid_bodies_push_force(rigid_bodies, slot, forces[i]);
+        rigid_bodies_push_damper(rigid_bodies, slot, dampers[i]);
     }
 }
 
@@ -397,21 +1366,17 @@ void rigid_bodies_apply_force(RigidBodies * rigid_bodies,
                               RigidBodyId id,
                               Vec force)
 {
-    trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
-
-    rigid_bodies->forces[id] = vec_sum(rigid_bodies->forces[id], force);
+    rigid_bodies_push_force(rigid_bodies, rigid_bodies_slot(rigid_bodies, id), force);
 }
 
 void rigid_bodies_transform_velocity(RigidBodies *rigid_bodies,
                                      RigidBodyId id,
                                      mat3x3 trans_mat)
 {
-    trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
 
-    rigid_bodies->velocities[id] = point_mat3x3_product(
-        rigid_bodies->velocities[id],
+    rigid_bodies->velocities[slot] = point_mat3x3_product(
+        rigid_bodies->velocities[slot],
         trans_mat);
 }
 
@@ -419,23 +1384,345 @@ void rigid_bodies_teleport_to(RigidBodies *rigid_bodies,
                               RigidBodyId id,
                               Vec position)
 {
-    trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
-
-    rigid_bodies->bodies[id].x = position.x;
-    rigid_bodies->bodies[id].y = position.y;
+    const size_t slot = rigid_bodies_slot(rigid_bodies, id);
+
+    rigid_bodies->bodies[slot].x = position.x;
+    rigid_bodies->bodies[slot].y = position.y;
+    // Teleports are not interpolated
+    rigid_bodies->previous_positions[slot] = position;
+    rigid_bodies_wake_up(rigid_bodies, slot);
+    rigid_bodies->query_tree_moved = true;
 }
 
 void rigid_bodies_damper(RigidBodies *rigid_bodies,
                          RigidBodyId id,
                          Vec v)
+{
+    rigid_bodies_push_damper(rigid_bodies, rigid_bodies_slot(rigid_bodies, id), v);
+}
+
+void rigid_bodies_set_broadphase(RigidBodies *rigid_bodies,
+                                 RigidBodiesBroadphase broadphase)
 {
     trace_assert(rigid_bodies);
-    trace_assert(id < rigid_bodies->count);
+    trace_assert(broadphase < RIGID_BODIES_BROADPHASE_N);
 
-    rigid_bodies_apply_force(
-        rigid_bodies, id,
-        vec(
-            rigid_bodies->velocities[id].x * v.x,
-            rigid_bodies->velocities[id].y * v.y));
+    rigid_bodies->broadphase = broadphase;
+}
+
+/* The snapshot is the header followed by a copy of the block and
+ * the order of the sweep and prune */
+typedef struct {
+    size_t capacity;
+    size_t count;
+    size_t deleted_count;
+    size_t epoch;
+    size_t order_count;
+} RigidBodiesSnapshotHeader;
+
+static size_t rigid_bodies_snapshot_block_offset(void)
+{
+    return (sizeof(RigidBodiesSnapshotHeader) + RIGID_BODIES_BLOCK_ALIGN - 1)
+        / RIGID_BODIES_BLOCK_ALIGN * RIGID_BODIES_BLOCK_ALIGN;
+}
+
+size_t rigid_bodies_snapshot_size(const RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    size_t offsets[COLUMN_N];
+    const size_t *order = NULL;
+
+    return rigid_bodies_snapshot_block_offset()
+        + rigid_bodies_block_layout(rigid_bodies->capacity, offsets)
+        + sizeof(size_t) * sweep_and_prune_order(rigid_bodies->sweep_and_prune, &order);
+}
+
+void rigid_bodies_snapshot(const RigidBodies *rigid_bodies,
+                           void *buffer)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(buffer);
+
+    char *bytes = buffer;
+    size_t offsets[COLUMN_N];
+    const size_t block_size = rigid_bodies_block_layout(rigid_bodies->capacity, offsets);
+    const size_t *order = NULL;
+
+    const RigidBodiesSnapshotHeader header = {
+        .capacity = rigid_bodies->capacity,
+        .count = rigid_bodies->count,
+        .deleted_count = rigid_bodies->deleted_count,
+        .epoch = rigid_bodies->epoch,
+        .order_count = sweep_and_prune_order(rigid_bodies->sweep_and_prune, &order)
+    };
+
+    memcpy(bytes, &header, sizeof(header));
+    bytes += rigid_bodies_snapshot_block_offset();
+    memcpy(bytes, rigid_bodies->block, block_size);
+    bytes += block_size;
+    memcpy(bytes, order, sizeof(size_t) * header.order_count);
+}
+
+int rigid_bodies_restore(RigidBodies *rigid_bodies,
+                         const void *buffer)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(buffer);
+
+    const char *bytes = buffer;
+    RigidBodiesSnapshotHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    bytes += rigid_bodies_snapshot_block_offset();
+
+    size_t offsets[COLUMN_N];
+    const size_t block_size = rigid_bodies_block_layout(header.capacity, offsets);
+
+    // The ids of the bodies added or removed since the snapshot are
+    // held outside and would be left dangling
+    if (header.epoch != rigid_bodies->epoch) {
+        log_fail("The rigid bodies were added or removed since the snapshot\n");
+        return -1;
+    }
+
+    if (header.capacity > rigid_bodies->capacity &&
+        rigid_bodies_grow(rigid_bodies, header.capacity) < 0) {
+        return -1;
+    }
+
+    if (sweep_and_prune_set_order(
+            rigid_bodies->sweep_and_prune,
+            (const size_t*) (bytes + block_size),
+            header.order_count) < 0) {
+        return -1;
+    }
+
+    // Freezing belongs to the owners of the bodies (the player
+    // freezes its body while dying), so it is kept through the
+    // restore. The slots may differ after the restore, so the flags
+    // are parked by the ids in the remap scratch column.
+    for (size_t index = 0; index < rigid_bodies->ids_count; ++index) {
+        const size_t slot = rigid_bodies->slots[index];
+        rigid_bodies->remap[index] =
+            slot != RIGID_BODIES_NO_SLOT && rigid_bodies->frozen[slot];
+    }
+
+    size_t current_offsets[COLUMN_N];
+    rigid_bodies_block_layout(rigid_bodies->capacity, current_offsets);
+    for (size_t column = 0; column < COLUMN_N; ++column) {
+        if (column == COLUMN_REMAP || column == COLUMN_FROZEN) {
+            continue;
+        }
+
+        memcpy(rigid_bodies->block + current_offsets[column],
+               bytes + offsets[column],
+               column_sizes[column] * header.capacity);
+    }
+
+    memset(rigid_bodies->frozen, 0, sizeof(bool) * rigid_bodies->capacity);
+    for (size_t index = 0; index < rigid_bodies->ids_count; ++index) {
+        const size_t slot = rigid_bodies->slots[index];
+        if (slot != RIGID_BODIES_NO_SLOT) {
+            rigid_bodies->frozen[slot] = rigid_bodies->remap[index] != 0;
+        }
+    }
+
+    rigid_bodies->count = header.count;
+    rigid_bodies->deleted_count = header.deleted_count;
+    rigid_bodies->query_tree_stale = true;
+
+    return 0;
+}
+
+static int rigid_bodies_update_query_tree(RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    if (rigid_bodies->query_tree_refits >= RIGID_BODIES_QUERY_TREE_REFITS) {
+        rigid_bodies->query_tree_stale = true;
+    }
+
+    if (!rigid_bodies->query_tree_stale) {
+        if (rigid_bodies->query_tree_moved) {
+            aabb_tree_refit(rigid_bodies->query_tree, rigid_bodies->bodies, rigid_bodies->count);
+            rigid_bodies->query_tree_moved = false;
+            rigid_bodies->query_tree_refits++;
+        }
+        return 0;
+    }
+
+    // The items of the tree are the slots. The bodies removed after
+    // the build are skipped by the queries.
+    if (rigid_bodies->deleted_count > 0) {
+        rigid_bodies_compact(rigid_bodies);
+    }
+
+    AabbTree *query_tree = create_aabb_tree(rigid_bodies->bodies, rigid_bodies->count);
+    if (query_tree == NULL) {
+        return -1;
+    }
+
+    if (rigid_bodies->query_tree == NULL) {
+        rigid_bodies->query_tree = PUSH_LT(rigid_bodies->lt, query_tree, destroy_aabb_tree);
+    } else {
+        rigid_bodies->query_tree = RESET_LT(rigid_bodies->lt, rigid_bodies->query_tree, query_tree);
+    }
+    rigid_bodies->query_tree_stale = false;
+    rigid_bodies->query_tree_moved = false;
+    rigid_bodies->query_tree_refits = 0;
+
+    return 0;
+}
+
+static bool rigid_bodies_slot_is_alive(void *param, size_t slot)
+{
+    const RigidBodies *rigid_bodies = param;
+    trace_assert(rigid_bodies);
+    return !rigid_bodies->deleted[slot];
+}
+
+typedef struct {
+    const RigidBodies *rigid_bodies;
+    RigidBodiesVisit visit;
+    void *param;
+} RigidBodiesQuery;
+
+static int rigid_bodies_query_visit(void *param, size_t slot)
+{
+    RigidBodiesQuery *query = param;
+    trace_assert(query);
+
+    if (query->rigid_bodies->deleted[slot]) {
+        return 0;
+    }
+
+    return query->visit(query->param, query->rigid_bodies->ids[slot]);
+}
+
+int rigid_bodies_query_rect(RigidBodies *rigid_bodies,
+                            Rect area,
+                            RigidBodiesVisit visit,
+                            void *param)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(visit);
+
+    if (rigid_bodies_update_query_tree(rigid_bodies) < 0) {
+        return -1;
+    }
+
+    RigidBodiesQuery query = {
+        .rigid_bodies = rigid_bodies,
+        .visit = visit,
+        .param = param
+    };
+
+    return aabb_tree_query(rigid_bodies->query_tree, area, rigid_bodies_query_visit, &query);
+}
+
+int rigid_bodies_raycast(RigidBodies *rigid_bodies,
+                         Vec begin, Vec end,
+                         RigidBodyId *id,
+                         float *t)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(id);
+    trace_assert(t);
+
+    if (rigid_bodies_update_query_tree(rigid_bodies) < 0) {
+        return -1;
+    }
+
+    size_t slot = 0;
+    if (!aabb_tree_raycast(
+            rigid_bodies->query_tree,
+            begin, end,
+            rigid_bodies_slot_is_alive, rigid_bodies,
+            &slot, t)) {
+        return 0;
+    }
+
+    *id = rigid_bodies->ids[slot];
+    return 1;
+}
+
+int rigid_bodies_nearest(RigidBodies *rigid_bodies,
+                         Vec point,
+                         RigidBodyId *id)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(id);
+
+    if (rigid_bodies_update_query_tree(rigid_bodies) < 0) {
+        return -1;
+    }
+
+    size_t slot = 0;
+    if (!aabb_tree_nearest(
+            rigid_bodies->query_tree,
+            point,
+            rigid_bodies_slot_is_alive, rigid_bodies,
+            &slot)) {
+        return 0;
+    }
+
+    *id = rigid_bodies->ids[slot];
+    return 1;
+}
+
+int rigid_bodies_set_threads_count(RigidBodies *rigid_bodies,
+                                   size_t threads_count)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(threads_count > 0);
+
+    WorkerPool *workers = NULL;
+    if (threads_count > 1) {
+        workers = create_worker_pool(threads_count);
+        if (workers == NULL) {
+            return -1;
+        }
+    }
+
+    if (rigid_bodies->workers == NULL) {
+        rigid_bodies->workers = PUSH_LT(rigid_bodies->lt, workers, destroy_worker_pool);
+    } else if (workers == NULL) {
+        destroy_worker_pool(RELEASE_LT(rigid_bodies->lt, rigid_bodies->workers));
+        rigid_bodies->workers = NULL;
+    } else {
+        rigid_bodies->workers = RESET_LT(rigid_bodies->lt, rigid_bodies->workers, workers);
+    }
+
+    return 0;
+}
+
+void rigid_bodies_wake_up_all(RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+
+    for (size_t i = 0; i < rigid_bodies->count; ++i) {
+        rigid_bodies_wake_up(rigid_bodies, i);
+    }
+}
+
+void rigid_bodies_freeze(RigidBodies *rigid_bodies,
+                         RigidBodyId id,
+                         bool frozen)
+{
+    rigid_bodies->frozen[rigid_bodies_slot(rigid_bodies, id)] = frozen;
+}
+
+RigidBodiesStats rigid_bodies_stats(const RigidBodies *rigid_bodies)
+{
+    trace_assert(rigid_bodies);
+    return rigid_bodies->stats;
+}
+
+void rigid_bodies_set_solver_iterations(RigidBodies *rigid_bodies,
+                                        size_t iterations)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(iterations > 0);
+
+    rigid_bodies->solver_iterations = iterations;
 }
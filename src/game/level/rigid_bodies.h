@@ -1,6 +1,8 @@
 #ifndef RIGID_BODIES_H_
 #define RIGID_BODIES_H_
 
+#include <stdbool.h>
+
 typedef struct RigidBodies RigidBodies;
 typedef struct Camera Camera;
 typedef struct Platforms Platforms;
@@ -8,19 +10,59 @@ typedef struct LineStream LineStream;
 
 typedef size_t RigidBodyId;
 
+typedef enum RigidBodiesBroadphase {
+    RIGID_BODIES_BROADPHASE_BRUTE_FORCE = 0,
+    RIGID_BODIES_BROADPHASE_GRID,
+    RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE,
+
+    RIGID_BODIES_BROADPHASE_N
+} RigidBodiesBroadphase;
+
+/** \brief What the last rigid_bodies_collide did.
+ */
+typedef struct RigidBodiesStats {
+    // Pairs of bodies found by the broadphase
+    size_t contacts;
+    // Pairs that actually collided
+    size_t collisions;
+    // Passes over the contacts summed over the islands
+    size_t solver_iterations;
+} RigidBodiesStats;
+
+/** \brief Creates the bodies with the initial capacity.
+ *
+ * The capacity grows on its own as the bodies are added.
+ */
 RigidBodies *create_rigid_bodies(size_t capacity);
 void destroy_rigid_bodies(RigidBodies *rigid_bodies);
 
 int rigid_bodies_collide(RigidBodies *rigid_bodies,
                          const Platforms *platforms);
 
+/** \brief Integrates all of the live bodies in one pass.
+ *
+ * Sleeping and frozen bodies stay in place. The forces of all of the
+ * bodies are reset.
+ */
+void rigid_bodies_integrate_all(RigidBodies *rigid_bodies,
+                                float delta_time);
+
 int rigid_bodies_update(RigidBodies *rigid_bodies,
                         RigidBodyId id,
                         float delta_time);
 
+/** \brief Renders the body between its positions before and after
+ * the last step.
+ *
+ * alpha is the fraction of the step that has passed since the last
+ * step: 0.0f renders the previous position, 1.0f the current one.
+ * It lives in rigid_bodies_render.c, so the physics can be built
+ * without the renderer.
+ */
 int rigid_bodies_render(RigidBodies *rigid_bodies,
                         RigidBodyId id,
-                        Camera *camera);
+                        Camera *camera,
+                        float alpha);
 RigidBodyId rigid_bodies_add(RigidBodies *rigid_bodies,
                              Rect rect,
                              Color color);
@@ -29,8 +71,39 @@ RigidBodyId rigid_bodies_add_from_line_stream(RigidBodies *rigid_bodies,
 void rigid_bodies_remove(RigidBodies *rigid_bodies,
                          RigidBodyId id);
 
+/** \brief Checks that the id belongs to a body that was not removed.
+ *
+ * All of the other functions that take an id expect it to be alive.
+ * Check the ids that come from outside (for example, from the
+ * scripts) with it first.
+ */
+int rigid_bodies_is_alive(const RigidBodies *rigid_bodies,
+                          RigidBodyId id);
+
+/** \brief Moves the live bodies over the slots of the removed ones.
+ *
+ * The ids of the bodies stay the same. rigid_bodies_collide calls it
+ * on its own once a quarter of the slots is dead.
+ */
+void rigid_bodies_compact(RigidBodies *rigid_bodies);
+
 Rect rigid_bodies_hitbox(const RigidBodies *rigid_bodies,
                          RigidBodyId id);
+/** \brief Copies the hitboxes of count bodies into hitboxes.
+ */
+void rigid_bodies_hitboxes(const RigidBodies *rigid_bodies,
+                           const RigidBodyId *ids,
+                           size_t count,
+                           Rect *hitboxes);
+Color rigid_bodies_color(const RigidBodies *rigid_bodies,
+                         RigidBodyId id);
+Vec rigid_bodies_velocity(const RigidBodies *rigid_bodies,
+                          RigidBodyId id);
+Vec rigid_bodies_movement(const RigidBodies *rigid_bodies,
+                          RigidBodyId id);
+Rect rigid_bodies_interpolated_hitbox(const RigidBodies *rigid_bodies,
+                                      RigidBodyId id,
+                                      float alpha);
 
 void rigid_bodies_move(RigidBodies *rigid_bodies,
                        RigidBodyId id,
@@ -43,6 +116,17 @@ void rigid_bodies_apply_force(RigidBodies * rigid_bodies,
                               RigidBodyId id,
                               Vec force);
 
+/** \brief Applies forces[i] and the damper dampers[i] to the body ids[i].
+ *
+ * The same as rigid_bodies_apply_force followed by
+ * rigid_bodies_damper for every body, but in one pass.
+ */
+void rigid_bodies_apply_forces(RigidBodies *rigid_bodies,
+                               const RigidBodyId *ids,
+                               const Vec *forces,
+                               const Vec *dampers,
+                               size_t count);
+
 void rigid_bodies_apply_omniforce(RigidBodies *rigid_bodies,
                                   Vec force);
 
@@ -58,5 +142,96 @@ void rigid_bodies_damper(RigidBodies *rigid_bodies,
                          RigidBodyId id,
                          Vec v);
 
+void rigid_bodies_set_broadphase(RigidBodies *rigid_bodies,
+                                 RigidBodiesBroadphase broadphase);
+
+/** \brief Sets how many times the contacts are solved per step at most.
+ */
+void rigid_bodies_set_solver_iterations(RigidBodies *rigid_bodies,
+                                        size_t iterations);
+
+RigidBodiesStats rigid_bodies_stats(const RigidBodies *rigid_bodies);
+
+/** \brief The size of the buffer for rigid_bodies_snapshot.
+ */
+size_t rigid_bodies_snapshot_size(const RigidBodies *rigid_bodies);
+
+/** \brief Copies the whole state of the bodies into the buffer.
+ *
+ * Restoring the snapshot brings the bodies back exactly, so the steps
+ * after rigid_bodies_restore repeat the steps after the snapshot.
+ */
+void rigid_bodies_snapshot(const RigidBodies *rigid_bodies,
+                           void *buffer);
+
+/** \brief Brings the bodies back to the state of the snapshot.
+ *
+ * Fails if any bodies were added or removed since the snapshot. The
+ * frozen flags are not restored, they stay as their owners set them
+ * last.
+ */
+int rigid_bodies_restore(RigidBodies *rigid_bodies,
+                         const void *buffer);
+
+/** \brief Callback of rigid_bodies_query_rect. Negative result stops the query.
+ */
+typedef int (*RigidBodiesVisit)(void *param, RigidBodyId id);
+
+/** \brief Calls visit with every body that overlaps the area.
+ *
+ * The queries share a tree over the bodies. The first query after a
+ * step refits it to the moved bodies. It is rebuilt after the bodies
+ * were added or compacted and every so often to stay tight. Returns
+ * -1 if the tree could not be built or visit stopped the query.
+ */
+int rigid_bodies_query_rect(RigidBodies *rigid_bodies,
+                            Rect area,
+                            RigidBodiesVisit visit,
+                            void *param);
+
+/** \brief Finds the first body hit by the segment from begin to end.
+ *
+ * The bodies that contain begin are not hit, so a body can cast
+ * from inside itself (the same as platforms_raycast and
+ * lava_raycast). Returns 1 and stores
+ * the body and the fraction t of the segment before the hit, 0 if
+ * nothing is hit and -1 on failure.
+ */
+int rigid_bodies_raycast(RigidBodies *rigid_bodies,
+                         Vec begin, Vec end,
+                         RigidBodyId *id,
+                         float *t);
+
+/** \brief Finds the body closest to the point.
+ *
+ * A body that contains the point is the closest one. Returns 1 if
+ * there is any body, 0 if not and -1 on failure.
+ */
+int rigid_bodies_nearest(RigidBodies *rigid_bodies,
+                         Vec point,
+                         RigidBodyId *id);
+
+/** \brief Spreads the step over that many threads.
+ *
+ * The independent islands of the bodies are solved in parallel. The
+ * result is the same for any number of threads. One thread (the
+ * default) does everything on the calling thread.
+ */
+int rigid_bodies_set_threads_count(RigidBodies *rigid_bodies,
+                                   size_t threads_count);
+
+/** \brief Wakes up all of the sleeping bodies.
+ *
+ * Call it when the world around the bodies has changed (for example,
+ * the platforms were reloaded) so they do not keep hanging in the air.
+ */
+void rigid_bodies_wake_up_all(RigidBodies *rigid_bodies);
+
+/** \brief Frozen bodies are skipped by rigid_bodies_integrate_all
+ * but still collide with the other bodies.
+ */
+void rigid_bodies_freeze(RigidBodies *rigid_bodies,
+                         RigidBodyId id,
+                         bool frozen);
 
 #endif  // RIGID_BODIES_H_
@@ -0,0 +1,448 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+#include "system/stacktrace.h"
+#include "./spatial_grid.h"
+
+#define SPATIAL_GRID_INIT_CAPACITY 64
+// Rects that span more cells than that are not put into the grid and
+// are tested against every other rect instead
+#define SPATIAL_GRID_MAX_CELLS_PER_RECT 64
+// Keeps the cell coordinates of the runaway bodies within int
+#define SPATIAL_GRID_MAX_CELL 1000000.0f
+
+typedef struct Cell {
+    int x, y;
+    size_t bucket;
+    size_t index;
+} Cell;
+
+struct SpatialGrid
+{
+    Lt *lt;
+    float cell_size;
+
+    size_t cells_capacity;
+    size_t cells_count;
+    Cell *cells;
+
+    size_t sorted_cells_capacity;
+    Cell *sorted_cells;
+
+    size_t buckets_capacity;
+    size_t buckets_count;
+    size_t *buckets;
+
+    size_t oversized_capacity;
+    size_t oversized_count;
+    size_t *oversized;
+
+    size_t pairs_capacity;
+    size_t pairs_count;
+    size_t *pairs;
+};
+
+SpatialGrid *create_spatial_grid(float cell_size)
+{
+    trace_assert(cell_size > 0.0f);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    SpatialGrid *grid = PUSH_LT(lt, nth_calloc(1, sizeof(SpatialGrid)), free);
+    if (grid == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    grid->lt = lt;
+    grid->cell_size = cell_size;
+
+    grid->cells_capacity = SPATIAL_GRID_INIT_CAPACITY;
+    grid->cells = PUSH_LT(lt, nth_calloc(grid->cells_capacity, sizeof(Cell)), free);
+    if (grid->cells == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    grid->sorted_cells_capacity = SPATIAL_GRID_INIT_CAPACITY;
+    grid->sorted_cells = PUSH_LT(lt, nth_calloc(grid->sorted_cells_capacity, sizeof(Cell)), free);
+    if (grid->sorted_cells == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    grid->buckets_capacity = SPATIAL_GRID_INIT_CAPACITY;
+    grid->buckets = PUSH_LT(lt, nth_calloc(grid->buckets_capacity + 1, sizeof(size_t)), free);
+    if (grid->buckets == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    grid->oversized_capacity = SPATIAL_GRID_INIT_CAPACITY;
+    grid->oversized = PUSH_LT(lt, nth_calloc(grid->oversized_capacity, sizeof(size_t)), free);
+    if (grid->oversized == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    grid->pairs_capacity = SPATIAL_GRID_INIT_CAPACITY;
+    grid->pairs = PUSH_LT(lt, nth_calloc(grid->pairs_capacity * 2, sizeof(size_t)), free);
+    if (grid->pairs == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    return grid;
+}
+
+void destroy_spatial_grid(SpatialGrid *grid)
+{
+    trace_assert(grid);
+    RETURN_LT0(grid->lt);
+}
+
+static void *spatial_grid_reserve(SpatialGrid *grid,
+                                  void *data,
+                                  size_t *capacity,
+                                  size_t required,
+                                  size_t element_size)
+{
+    trace_assert(grid);
+    trace_assert(data);
+    trace_assert(capacity);
+
+    if (required <= *capacity) {
+        return data;
+    }
+
+    size_t new_capacity = *capacity;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    void *new_data = nth_realloc(data, new_capacity * element_size);
+    if (new_data == NULL) {
+        return NULL;
+    }
+
+    *capacity = new_capacity;
+    return REPLACE_LT(grid->lt, data, new_data);
+}
+
+static int spatial_grid_cell_coord(float x, float cell_size)
+{
+    return (int) fmaxf(-SPATIAL_GRID_MAX_CELL,
+                       fminf(SPATIAL_GRID_MAX_CELL, floorf(x / cell_size)));
+}
+
+static size_t spatial_grid_bucket(int x, int y, size_t buckets_count)
+{
+    const uint32_t hash = ((uint32_t) x * 73856093u) ^ ((uint32_t) y * 19349663u);
+    return (size_t) hash & (buckets_count - 1);
+}
+
+static int spatial_grid_push_pair(SpatialGrid *grid, size_t i1, size_t i2)
+{
+    trace_assert(grid);
+
+    size_t *pairs = spatial_grid_reserve(
+        grid, grid->pairs, &grid->pairs_capacity,
+        grid->pairs_count + 1, sizeof(size_t) * 2);
+    if (pairs == NULL) {
+        return -1;
+    }
+    grid->pairs = pairs;
+
+    grid->pairs[grid->pairs_count * 2] = i1 < i2 ? i1 : i2;
+    grid->pairs[grid->pairs_count * 2 + 1] = i1 < i2 ? i2 : i1;
+    grid->pairs_count++;
+
+    return 0;
+}
+
+// Every rect is inflated by a half of the margin, so the inflated
+// rects overlap exactly when the original ones are closer than margin
+static Rect spatial_grid_inflate(Rect rect, float margin)
+{
+    return rect_from_points(
+        vec(rect.x - margin * 0.5f, rect.y - margin * 0.5f),
+        vec(rect.x + rect.w + margin * 0.5f, rect.y + rect.h + margin * 0.5f));
+}
+
+static size_t spatial_grid_cells_count(const SpatialGrid *grid, Rect r)
+{
+    trace_assert(grid);
+
+    const int x0 = spatial_grid_cell_coord(r.x, grid->cell_size);
+    const int y0 = spatial_grid_cell_coord(r.y, grid->cell_size);
+    const int x1 = spatial_grid_cell_coord(r.x + r.w, grid->cell_size);
+    const int y1 = spatial_grid_cell_coord(r.y + r.h, grid->cell_size);
+    return (size_t) (x1 - x0 + 1) * (size_t) (y1 - y0 + 1);
+}
+
+/* Only the rects that are not still are put into the cells. The
+ * still ones are looked up in the cells afterwards. */
+static int spatial_grid_rebuild(SpatialGrid *grid,
+                                const Rect *rects,
+                                const bool *skip,
+                                const bool *still,
+                                size_t count,
+                                float margin)
+{
+    trace_assert(grid);
+    trace_assert(rects);
+    trace_assert(skip);
+    trace_assert(still);
+
+    grid->cells_count = 0;
+    grid->oversized_count = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (skip[i] || still[i]) {
+            continue;
+        }
+
+        const Rect r = spatial_grid_inflate(rects[i], margin);
+        const int x0 = spatial_grid_cell_coord(r.x, grid->cell_size);
+        const int y0 = spatial_grid_cell_coord(r.y, grid->cell_size);
+        const int x1 = spatial_grid_cell_coord(r.x + r.w, grid->cell_size);
+        const int y1 = spatial_grid_cell_coord(r.y + r.h, grid->cell_size);
+        const size_t n = spatial_grid_cells_count(grid, r);
+
+        if (n > SPATIAL_GRID_MAX_CELLS_PER_RECT) {
+            size_t *oversized = spatial_grid_reserve(
+                grid, grid->oversized, &grid->oversized_capacity,
+                grid->oversized_count + 1, sizeof(size_t));
+            if (oversized == NULL) {
+                return -1;
+            }
+            grid->oversized = oversized;
+            grid->oversized[grid->oversized_count++] = i;
+            continue;
+        }
+
+        Cell *cells = spatial_grid_reserve(
+            grid, grid->cells, &grid->cells_capacity,
+            grid->cells_count + n, sizeof(Cell));
+        if (cells == NULL) {
+            return -1;
+        }
+        grid->cells = cells;
+
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                Cell *cell = &grid->cells[grid->cells_count++];
+                cell->x = x;
+                cell->y = y;
+                cell->index = i;
+            }
+        }
+    }
+
+    size_t buckets_count = SPATIAL_GRID_INIT_CAPACITY;
+    while (buckets_count < grid->cells_count) {
+        buckets_count *= 2;
+    }
+
+    size_t *buckets = spatial_grid_reserve(
+        grid, grid->buckets, &grid->buckets_capacity,
+        buckets_count + 1, sizeof(size_t));
+    if (buckets == NULL) {
+        return -1;
+    }
+    grid->buckets = buckets;
+    grid->buckets_count = buckets_count;
+
+    Cell *sorted_cells = spatial_grid_reserve(
+        grid, grid->sorted_cells, &grid->sorted_cells_capacity,
+        grid->cells_count, sizeof(Cell));
+    if (sorted_cells == NULL) {
+        return -1;
+    }
+    grid->sorted_cells = sorted_cells;
+
+    // Counting sort of the cells by their buckets
+    memset(grid->buckets, 0, sizeof(size_t) * (buckets_count + 1));
+    for (size_t i = 0; i < grid->cells_count; ++i) {
+        grid->cells[i].bucket = spatial_grid_bucket(
+            grid->cells[i].x, grid->cells[i].y, buckets_count);
+        grid->buckets[grid->cells[i].bucket + 1]++;
+    }
+
+    for (size_t i = 0; i < buckets_count; ++i) {
+        grid->buckets[i + 1] += grid->buckets[i];
+    }
+
+    for (size_t i = 0; i < grid->cells_count; ++i) {
+        grid->sorted_cells[grid->buckets[grid->cells[i].bucket]++] = grid->cells[i];
+    }
+
+    // The scatter above shifted every bucket start to the next one
+    memmove(grid->buckets + 1, grid->buckets, sizeof(size_t) * buckets_count);
+    grid->buckets[0] = 0;
+
+    return 0;
+}
+
+static int spatial_grid_compare_indices(const void *a, const void *b)
+{
+    const size_t i1 = *(const size_t*) a;
+    const size_t i2 = *(const size_t*) b;
+    return (i1 > i2) - (i1 < i2);
+}
+
+static bool spatial_grid_is_oversized(const SpatialGrid *grid, size_t i)
+{
+    trace_assert(grid);
+    return bsearch(&i, grid->oversized, grid->oversized_count,
+                   sizeof(size_t), spatial_grid_compare_indices) != NULL;
+}
+
+// Reports the pair only from the cell that contains the top-left
+// corner of the intersection of the inflated rects, so the rects that
+// share several cells are reported once
+static int spatial_grid_check_pair(SpatialGrid *grid,
+                                   const Rect *rects,
+                                   float margin,
+                                   int x, int y,
+                                   size_t i1, size_t i2)
+{
+    trace_assert(grid);
+
+    const Rect r1 = spatial_grid_inflate(rects[i1], margin);
+    const Rect r2 = spatial_grid_inflate(rects[i2], margin);
+
+    if (spatial_grid_cell_coord(fmaxf(r1.x, r2.x), grid->cell_size) != x ||
+        spatial_grid_cell_coord(fmaxf(r1.y, r2.y), grid->cell_size) != y) {
+        return 0;
+    }
+
+    if (rects_overlap(r1, r2)) {
+        return spatial_grid_push_pair(grid, i1, i2);
+    }
+
+    return 0;
+}
+
+// Pairs the still rect with the moving rects in the cells it covers
+static int spatial_grid_look_up(SpatialGrid *grid,
+                                const Rect *rects,
+                                const bool *skip,
+                                const bool *still,
+                                size_t count,
+                                float margin,
+                                size_t i1)
+{
+    trace_assert(grid);
+
+    const Rect r = spatial_grid_inflate(rects[i1], margin);
+
+    if (spatial_grid_cells_count(grid, r) > SPATIAL_GRID_MAX_CELLS_PER_RECT) {
+        // The oversized moving rects check all of the rects on their own
+        for (size_t i2 = 0; i2 < count; ++i2) {
+            if (skip[i2] || still[i2] || spatial_grid_is_oversized(grid, i2)) {
+                continue;
+            }
+
+            if (rects_overlap(r, spatial_grid_inflate(rects[i2], margin)) &&
+                spatial_grid_push_pair(grid, i1, i2) < 0) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
+
+    const int x0 = spatial_grid_cell_coord(r.x, grid->cell_size);
+    const int y0 = spatial_grid_cell_coord(r.y, grid->cell_size);
+    const int x1 = spatial_grid_cell_coord(r.x + r.w, grid->cell_size);
+    const int y1 = spatial_grid_cell_coord(r.y + r.h, grid->cell_size);
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const size_t b = spatial_grid_bucket(x, y, grid->buckets_count);
+
+            for (size_t j = grid->buckets[b]; j < grid->buckets[b + 1]; ++j) {
+                const Cell *cell = &grid->sorted_cells[j];
+
+                if (cell->x == x && cell->y == y &&
+                    spatial_grid_check_pair(grid, rects, margin, x, y, i1, cell->index) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int spatial_grid_find_pairs(SpatialGrid *grid,
+                            const Rect *rects,
+                            const bool *skip,
+                            const bool *still,
+                            size_t count,
+                            float margin,
+                            const size_t **pairs,
+                            size_t *pairs_count)
+{
+    trace_assert(grid);
+    trace_assert(rects);
+    trace_assert(skip);
+    trace_assert(still);
+    trace_assert(pairs);
+    trace_assert(pairs_count);
+
+    grid->pairs_count = 0;
+
+    if (spatial_grid_rebuild(grid, rects, skip, still, count, margin) < 0) {
+        return -1;
+    }
+
+    for (size_t b = 0; b < grid->buckets_count; ++b) {
+        for (size_t j = grid->buckets[b]; j < grid->buckets[b + 1]; ++j) {
+            const Cell *c1 = &grid->sorted_cells[j];
+
+            for (size_t k = j + 1; k < grid->buckets[b + 1]; ++k) {
+                const Cell *c2 = &grid->sorted_cells[k];
+
+                if (c1->x == c2->x && c1->y == c2->y &&
+                    spatial_grid_check_pair(grid, rects, margin, c1->x, c1->y, c1->index, c2->index) < 0) {
+                    return -1;
+                }
+            }
+        }
+    }
+
+    for (size_t j = 0; j < grid->oversized_count; ++j) {
+        const size_t i1 = grid->oversized[j];
+
+        for (size_t i2 = 0; i2 < count; ++i2) {
+            if (i1 == i2 || skip[i2]) {
+                continue;
+            }
+
+            // A pair of two oversized rects is reported by the one
+            // with the smaller index
+            if (i2 < i1 && spatial_grid_is_oversized(grid, i2)) {
+                continue;
+            }
+
+            if (rects_overlap(spatial_grid_inflate(rects[i1], margin),
+                              spatial_grid_inflate(rects[i2], margin)) &&
+                spatial_grid_push_pair(grid, i1, i2) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!skip[i] && still[i] &&
+            spatial_grid_look_up(grid, rects, skip, still, count, margin, i) < 0) {
+            return -1;
+        }
+    }
+
+    *pairs = grid->pairs;
+    *pairs_count = grid->pairs_count;
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef SPATIAL_GRID_H_
+#define SPATIAL_GRID_H_
+
+#include <stdbool.h>
+
+#include "math/rect.h"
+
+typedef struct SpatialGrid SpatialGrid;
+
+SpatialGrid *create_spatial_grid(float cell_size);
+void destroy_spatial_grid(SpatialGrid *grid);
+
+/** \brief Rebuilds the grid out of the rects and finds all of the
+ * pairs of rects that are closer than margin to each other.
+ *
+ * Rects with skip[i] set are ignored. Rects with still[i] set are not
+ * paired with each other, so they are not put into the grid and are
+ * only looked up in the cells of the other rects. The pairs are
+ * stored as flat (i1, i2) couples with i1 < i2 in a buffer owned by
+ * the grid which stays valid until the next call.
+ */
+int spatial_grid_find_pairs(SpatialGrid *grid,
+                            const Rect *rects,
+                            const bool *skip,
+                            const bool *still,
+                            size_t count,
+                            float margin,
+                            const size_t **pairs,
+                            size_t *pairs_count);
+
+#endif  // SPATIAL_GRID_H_
@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+#include "system/stacktrace.h"
+#include "./sweep_and_prune.h"
+
+#define SWEEP_AND_PRUNE_INIT_CAPACITY 64
+
+struct SweepAndPrune
+{
+    Lt *lt;
+
+    size_t order_capacity;
+    size_t order_count;
+    size_t *order;
+    float *keys;
+
+    size_t pairs_capacity;
+    size_t pairs_count;
+    size_t *pairs;
+};
+
+SweepAndPrune *create_sweep_and_prune(void)
+{
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    SweepAndPrune *sweep_and_prune = PUSH_LT(lt, nth_calloc(1, sizeof(SweepAndPrune)), free);
+    if (sweep_and_prune == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    sweep_and_prune->lt = lt;
+
+    sweep_and_prune->order_capacity = SWEEP_AND_PRUNE_INIT_CAPACITY;
+    sweep_and_prune->order = PUSH_LT(
+        lt,
+        nth_calloc(sweep_and_prune->order_capacity, sizeof(size_t)),
+        free);
+    if (sweep_and_prune->order == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    sweep_and_prune->keys = PUSH_LT(
+        lt,
+        nth_calloc(sweep_and_prune->order_capacity, sizeof(float)),
+        free);
+    if (sweep_and_prune->keys == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    sweep_and_prune->pairs_capacity = SWEEP_AND_PRUNE_INIT_CAPACITY;
+    sweep_and_prune->pairs = PUSH_LT(
+        lt,
+        nth_calloc(sweep_and_prune->pairs_capacity * 2, sizeof(size_t)),
+        free);
+    if (sweep_and_prune->pairs == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    return sweep_and_prune;
+}
+
+void destroy_sweep_and_prune(SweepAndPrune *sweep_and_prune)
+{
+    trace_assert(sweep_and_prune);
+    RETURN_LT0(sweep_and_prune->lt);
+}
+
+static int sweep_and_prune_reserve_order(SweepAndPrune *sweep_and_prune,
+                                         size_t required)
+{
+    trace_assert(sweep_and_prune);
+
+    if (required <= sweep_and_prune->order_capacity) {
+        return 0;
+    }
+
+    size_t new_capacity = sweep_and_prune->order_capacity;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    size_t *new_order = nth_realloc(sweep_and_prune->order, sizeof(size_t) * new_capacity);
+    if (new_order == NULL) {
+        return -1;
+    }
+    sweep_and_prune->order = REPLACE_LT(sweep_and_prune->lt, sweep_and_prune->order, new_order);
+
+    float *new_keys = nth_realloc(sweep_and_prune->keys, sizeof(float) * new_capacity);
+    if (new_keys == NULL) {
+        return -1;
+    }
+    sweep_and_prune->keys = REPLACE_LT(sweep_and_prune->lt, sweep_and_prune->keys, new_keys);
+
+    sweep_and_prune->order_capacity = new_capacity;
+
+    return 0;
+}
+
+static int sweep_and_prune_push_pair(SweepAndPrune *sweep_and_prune,
+                                     size_t i1, size_t i2)
+{
+    trace_assert(sweep_and_prune);
+
+    if (sweep_and_prune->pairs_count >= sweep_and_prune->pairs_capacity) {
+        size_t *new_pairs = nth_realloc(
+            sweep_and_prune->pairs,
+            sizeof(size_t) * 2 * sweep_and_prune->pairs_capacity * 2);
+        if (new_pairs == NULL) {
+            return -1;
+        }
+
+        sweep_and_prune->pairs = REPLACE_LT(sweep_and_prune->lt, sweep_and_prune->pairs, new_pairs);
+        sweep_and_prune->pairs_capacity *= 2;
+    }
+
+    sweep_and_prune->pairs[sweep_and_prune->pairs_count * 2] = i1 < i2 ? i1 : i2;
+    sweep_and_prune->pairs[sweep_and_prune->pairs_count * 2 + 1] = i1 < i2 ? i2 : i1;
+    sweep_and_prune->pairs_count++;
+
+    return 0;
+}
+
+/* Makes the order contain exactly the indices [0, count) keeping
+ * the relative order of the indices that were already there */
+static int sweep_and_prune_track(SweepAndPrune *sweep_and_prune,
+                                 size_t count)
+{
+    trace_assert(sweep_and_prune);
+
+    if (count < sweep_and_prune->order_count) {
+        size_t n = 0;
+        for (size_t k = 0; k < sweep_and_prune->order_count; ++k) {
+            if (sweep_and_prune->order[k] < count) {
+                sweep_and_prune->order[n++] = sweep_and_prune->order[k];
+            }
+        }
+        sweep_and_prune->order_count = n;
+    }
+
+    if (sweep_and_prune_reserve_order(sweep_and_prune, count) < 0) {
+        return -1;
+    }
+
+    while (sweep_and_prune->order_count < count) {
+        sweep_and_prune->order[sweep_and_prune->order_count] = sweep_and_prune->order_count;
+        sweep_and_prune->order_count++;
+    }
+
+    return 0;
+}
+
+int sweep_and_prune_find_pairs(SweepAndPrune *sweep_and_prune,
+                               const Rect *rects,
+                               const bool *skip,
+                               const bool *still,
+                               size_t count,
+                               float margin,
+                               const size_t **pairs,
+                               size_t *pairs_count)
+{
+    trace_assert(sweep_and_prune);
+    trace_assert(rects);
+    trace_assert(skip);
+    trace_assert(still);
+    trace_assert(pairs);
+    trace_assert(pairs_count);
+
+    sweep_and_prune->pairs_count = 0;
+
+    if (sweep_and_prune_track(sweep_and_prune, count) < 0) {
+        return -1;
+    }
+
+    size_t *order = sweep_and_prune->order;
+    float *keys = sweep_and_prune->keys;
+
+    for (size_t k = 0; k < count; ++k) {
+        keys[k] = rects[order[k]].x;
+    }
+
+    // Insertion sort. The order is almost sorted since the last call.
+    for (size_t k = 1; k < count; ++k) {
+        const float key = keys[k];
+        const size_t index = order[k];
+
+        size_t j = k;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            order[j] = order[j - 1];
+            --j;
+        }
+
+        keys[j] = key;
+        order[j] = index;
+    }
+
+    for (size_t k1 = 0; k1 < count; ++k1) {
+        const size_t i1 = order[k1];
+        if (skip[i1]) {
+            continue;
+        }
+
+        const Rect r1 = rect(rects[i1].x - margin,
+                             rects[i1].y - margin,
+                             rects[i1].w + margin * 2.0f,
+                             rects[i1].h + margin * 2.0f);
+
+        for (size_t k2 = k1 + 1; k2 < count && keys[k2] < r1.x + r1.w; ++k2) {
+            const size_t i2 = order[k2];
+
+            if (!skip[i2] &&
+                !(still[i1] && still[i2]) &&
+                rects_overlap(r1, rects[i2]) &&
+                sweep_and_prune_push_pair(sweep_and_prune, i1, i2) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    *pairs = sweep_and_prune->pairs;
+    *pairs_count = sweep_and_prune->pairs_count;
+
+    return 0;
+}
+
+void sweep_and_prune_remap(SweepAndPrune *sweep_and_prune,
+                           const size_t *remap,
+                           size_t count)
+{
+    trace_assert(sweep_and_prune);
+    trace_assert(remap);
+
+    size_t n = 0;
+    for (size_t k = 0; k < sweep_and_prune->order_count; ++k) {
+        const size_t index = remap[sweep_and_prune->order[k]];
+        if (index < count) {
+            sweep_and_prune->order[n++] = index;
+        }
+    }
+    sweep_and_prune->order_count = n;
+}
+
+size_t sweep_and_prune_order(const SweepAndPrune *sweep_and_prune,
+                             const size_t **order)
+{
+    trace_assert(sweep_and_prune);
+    trace_assert(order);
+
+    *order = sweep_and_prune->order;
+    return sweep_and_prune->order_count;
+}
+
+int sweep_and_prune_set_order(SweepAndPrune *sweep_and_prune,
+                              const size_t *order,
+                              size_t count)
+{
+    trace_assert(sweep_and_prune);
+    trace_assert(order || count == 0);
+
+    if (sweep_and_prune_reserve_order(sweep_and_prune, count) < 0) {
+        return -1;
+    }
+
+    if (count > 0) {
+        memcpy(sweep_and_prune->order, order, sizeof(size_t) * count);
+    }
+    sweep_and_prune->order_count = count;
+
+    return 0;
+}
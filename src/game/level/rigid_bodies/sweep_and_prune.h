@@ -0,0 +1,55 @@
+#ifndef SWEEP_AND_PRUNE_H_
+#define SWEEP_AND_PRUNE_H_
+
+#include <stdbool.h>
+
+#include "math/rect.h"
+
+typedef struct SweepAndPrune SweepAndPrune;
+
+SweepAndPrune *create_sweep_and_prune(void);
+void destroy_sweep_and_prune(SweepAndPrune *sweep_and_prune);
+
+/** \brief Finds all of the pairs of rects that are closer than
+ * margin to each other.
+ *
+ * Zero margin gives just the overlapping pairs. The order of the
+ * rects along the x axis is preserved between the calls and is fixed
+ * up with an insertion sort, so the rects that barely moved since the
+ * previous call cost almost nothing to sort. Rects with skip[i] set
+ * are ignored. Rects with still[i] set are not paired with each
+ * other. The pairs are stored as flat (i1, i2) couples with i1 < i2
+ * in a buffer owned by SweepAndPrune which stays valid until the next
+ * call.
+ */
+int sweep_and_prune_find_pairs(SweepAndPrune *sweep_and_prune,
+                               const Rect *rects,
+                               const bool *skip,
+                               const bool *still,
+                               size_t count,
+                               float margin,
+                               const size_t **pairs,
+                               size_t *pairs_count);
+
+/** \brief Renumbers the rects without losing their order.
+ *
+ * The rect i becomes the rect remap[i], or is forgotten if remap[i]
+ * is not less than count. The remap must keep the relative order of
+ * the indices.
+ */
+void sweep_and_prune_remap(SweepAndPrune *sweep_and_prune,
+                           const size_t *remap,
+                           size_t count);
+
+/** \brief The order of the rects along the x axis left by the last call.
+ *
+ * The rects with equal x keep the order they had before, so the
+ * order together with the rects determines the order of the pairs.
+ */
+size_t sweep_and_prune_order(const SweepAndPrune *sweep_and_prune,
+                             const size_t **order);
+int sweep_and_prune_set_order(SweepAndPrune *sweep_and_prune,
+                              const size_t *order,
+                              size_t count);
+
+#endif  // SWEEP_AND_PRUNE_H_
@@ -0,0 +1,60 @@
+#include "system/stacktrace.h"
+
+#include "game/camera.h"
+#include "game/level/rigid_bodies.h"
+
+int rigid_bodies_render(RigidBodies *rigid_bodies,
+                        RigidBodyId id,
+                        Camera *camera,
+                        float alpha)
+{
+    trace_assert(rigid_bodies);
+    trace_assert(camera);
+
+    const Rect body = rigid_bodies_interpolated_hitbox(rigid_bodies, id, alpha);
+    if (!camera_is_rect_visible(camera, body)) {
+        return 0;
+    }
+
+    if (camera_fill_rect(
+            camera,
+            body,
+            rigid_bodies_color(rigid_bodies, id)) < 0) {
+        return -1;
+    }
+
+    if (camera_render_debug_long(
+            camera,
+            "id: ",
+            (long int) id,
+            vec(body.x, body.y)) < 0) {
+        return -1;
+    }
+
+    const Rect hitbox = rigid_bodies_hitbox(rigid_bodies, id);
+    if (camera_render_debug_vec(
+            camera,
+            "p:",
+            vec(hitbox.x, hitbox.y),
+            vec(body.x, body.y + FONT_CHAR_HEIGHT * 2.0f)) < 0) {
+        return -1;
+    }
+
+    if (camera_render_debug_vec(
+            camera,
+            "v:",
+            rigid_bodies_velocity(rigid_bodies, id),
+            vec(body.x, body.y + FONT_CHAR_HEIGHT * 4.0f)) < 0) {
+        return -1;
+    }
+
+    if (camera_render_debug_vec(
+            camera,
+            "m:",
+            rigid_bodies_movement(rigid_bodies, id),
+            vec(body.x, body.y + FONT_CHAR_HEIGHT * 6.0f)) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -105,6 +105,10 @@ int level_picker_render(const LevelPicker *level_picker,
         return -1;
     }
 
+    if (camera_flush(camera) < 0) {
+        return -1;
+    }
+
     // Title //////////////////////////////
 
     const Vec title_size = menu_title_size(level_picker->menu_title);
@@ -1,8 +1,11 @@
 #include <SDL2/SDL.h>
 #include "system/stacktrace.h"
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "dynarray.h"
 #include "math/rect.h"
 #include "sdl/renderer.h"
 #include "sprite_font.h"
@@ -11,11 +14,37 @@
 #include "system/log.h"
 
 #define FONT_ROW_SIZE 18
+#define SPRITE_FONT_LAYOUT_MAX_LENGTH 64
+#define SPRITE_FONT_LAYOUTS_COUNT 256
+
+/* The glyphs of a piece of text relative to its position. Longer
+ * texts are laid out in pieces of SPRITE_FONT_LAYOUT_MAX_LENGTH
+ * characters. */
+typedef struct {
+    bool used;
+    char text[SPRITE_FONT_LAYOUT_MAX_LENGTH];
+    size_t length;
+    Vec size;
+    SDL_Rect src[SPRITE_FONT_LAYOUT_MAX_LENGTH];
+    Rect dest[SPRITE_FONT_LAYOUT_MAX_LENGTH];
+} Sprite_font_layout;
 
 struct Sprite_font
 {
     Lt *lt;
     SDL_Texture *texture;
+    int texture_width;
+    int texture_height;
+
+    // The layouts of the recently rendered texts keyed by the text and
+    // the size. A new layout replaces the one in its slot.
+    Sprite_font_layout *layouts;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // The glyphs that are drawn with one SDL_RenderGeometry, six
+    // vertices per glyph
+    Dynarray *vertices;
+#endif
 };
 
 Sprite_font *create_sprite_font_from_file(const char *bmp_file_path,
@@ -48,6 +77,9 @@ Sprite_font *create_sprite_font_from_file(const char *bmp_file_path,
         RETURN_LT(lt, NULL);
     }
 
+    sprite_font->texture_width = surface->w;
+    sprite_font->texture_height = surface->h;
+
     sprite_font->texture = PUSH_LT(
         lt,
         SDL_CreateTextureFromSurface(renderer, surface),
@@ -59,6 +91,21 @@ Sprite_font *create_sprite_font_from_file(const char *bmp_file_path,
 
     SDL_FreeSurface(RELEASE_LT(lt, surface));
 
+    sprite_font->layouts = PUSH_LT(
+        lt,
+        nth_calloc(SPRITE_FONT_LAYOUTS_COUNT, sizeof(Sprite_font_layout)),
+        free);
+    if (sprite_font->layouts == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    sprite_font->vertices = PUSH_LT(lt, create_dynarray(sizeof(SDL_Vertex)), destroy_dynarray);
+    if (sprite_font->vertices == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+#endif
+
     sprite_font->lt = lt;
 
     return sprite_font;
@@ -87,6 +134,216 @@ static SDL_Rect sprite_font_char_rect(const Sprite_font *sprite_font, char x)
     }
 }
 
+/* Finds the layout of the first SPRITE_FONT_LAYOUT_MAX_LENGTH
+ * characters of the text, laying them out if they are not cached. */
+static const Sprite_font_layout *sprite_font_layout(const Sprite_font *sprite_font,
+                                                    const char *text,
+                                                    Vec size)
+{
+    trace_assert(sprite_font);
+    trace_assert(text);
+
+    // FNV-1a of the text and the size. The length comes out of the
+    // same pass.
+    uint32_t hash = 2166136261u;
+    size_t length = 0;
+    while (length < SPRITE_FONT_LAYOUT_MAX_LENGTH && text[length] != '\0') {
+        hash = (hash ^ (uint8_t) text[length]) * 16777619u;
+        length++;
+    }
+    hash = (hash ^ (uint32_t) (size.x * 64.0f)) * 16777619u;
+    hash = (hash ^ (uint32_t) (size.y * 64.0f)) * 16777619u;
+
+    Sprite_font_layout *layout = &sprite_font->layouts[hash % SPRITE_FONT_LAYOUTS_COUNT];
+    if (layout->used &&
+        layout->length == length &&
+        layout->size.x == size.x &&
+        layout->size.y == size.y &&
+        memcmp(layout->text, text, length) == 0) {
+        return layout;
+    }
+
+    layout->used = true;
+    memcpy(layout->text, text, length);
+    layout->length = length;
+    layout->size = size;
+
+    for (size_t i = 0; i < length; ++i) {
+        layout->src[i] = sprite_font_char_rect(sprite_font, text[i]);
+        layout->dest[i] = rect(
+            (float) FONT_CHAR_WIDTH * (float) i * size.x,
+            0.0f,
+            (float) layout->src[i].w * size.x,
+            (float) layout->src[i].h * size.y);
+    }
+
+    return layout;
+}
+
+/* The glyphs are drawn between sprite_font_draw_begin and
+ * sprite_font_draw_end. With SDL_RenderGeometry they are collected
+ * and submitted together at the end, otherwise every glyph is copied
+ * right away. */
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+static int sprite_font_draw_begin(const Sprite_font *sprite_font,
+                                  SDL_Color color)
+{
+    trace_assert(sprite_font);
+    (void) color;
+    dynarray_clear(sprite_font->vertices);
+    return 0;
+}
+
+static int sprite_font_draw_layout(const Sprite_font *sprite_font,
+                                   SDL_Renderer *renderer,
+                                   const Sprite_font_layout *layout,
+                                   Vec position,
+                                   SDL_Color color)
+{
+    trace_assert(sprite_font);
+    trace_assert(renderer);
+    trace_assert(layout);
+
+    const float tw = (float) sprite_font->texture_width;
+    const float th = (float) sprite_font->texture_height;
+
+    for (size_t i = 0; i < layout->length; ++i) {
+        const SDL_Rect src = layout->src[i];
+        const float x0 = position.x + layout->dest[i].x;
+        const float y0 = position.y + layout->dest[i].y;
+        const float x1 = x0 + layout->dest[i].w;
+        const float y1 = y0 + layout->dest[i].h;
+        const float u0 = (float) src.x / tw;
+        const float v0 = (float) src.y / th;
+        const float u1 = (float) (src.x + src.w) / tw;
+        const float v1 = (float) (src.y + src.h) / th;
+
+        const SDL_Vertex vertices[6] = {
+            { { x0, y0 }, color, { u0, v0 } },
+            { { x1, y0 }, color, { u1, v0 } },
+            { { x1, y1 }, color, { u1, v1 } },
+            { { x0, y0 }, color, { u0, v0 } },
+            { { x1, y1 }, color, { u1, v1 } },
+            { { x0, y1 }, color, { u0, v1 } }
+        };
+
+        for (size_t j = 0; j < 6; ++j) {
+            if (dynarray_push(sprite_font->vertices, &vertices[j]) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int sprite_font_draw_end(const Sprite_font *sprite_font,
+                                SDL_Renderer *renderer)
+{
+    trace_assert(sprite_font);
+    trace_assert(renderer);
+
+    const size_t count = dynarray_count(sprite_font->vertices);
+    if (count == 0) {
+        return 0;
+    }
+
+    if (SDL_RenderGeometry(
+            renderer,
+            sprite_font->texture,
+            dynarray_data(sprite_font->vertices), (int) count,
+            NULL, 0) < 0) {
+        log_fail("SDL_RenderGeometry: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    dynarray_clear(sprite_font->vertices);
+
+    return 0;
+}
+#else
+static int sprite_font_draw_begin(const Sprite_font *sprite_font,
+                                  SDL_Color color)
+{
+    trace_assert(sprite_font);
+
+    if (SDL_SetTextureColorMod(sprite_font->texture, color.r, color.g, color.b) < 0) {
+        log_fail("SDL_SetTextureColorMod: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    if (SDL_SetTextureAlphaMod(sprite_font->texture, color.a) < 0) {
+        log_fail("SDL_SetTextureAlphaMod: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    return 0;
+}
+
+static int sprite_font_draw_layout(const Sprite_font *sprite_font,
+                                   SDL_Renderer *renderer,
+                                   const Sprite_font_layout *layout,
+                                   Vec position,
+                                   SDL_Color color)
+{
+    trace_assert(sprite_font);
+    trace_assert(renderer);
+    trace_assert(layout);
+    (void) color;
+
+    for (size_t i = 0; i < layout->length; ++i) {
+        const SDL_Rect dest_rect = rect_for_sdl(
+            rect(
+                position.x + layout->dest[i].x,
+                position.y + layout->dest[i].y,
+                layout->dest[i].w,
+                layout->dest[i].h));
+        if (SDL_RenderCopy(renderer, sprite_font->texture, &layout->src[i], &dest_rect) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sprite_font_draw_end(const Sprite_font *sprite_font,
+                                SDL_Renderer *renderer)
+{
+    trace_assert(sprite_font);
+    trace_assert(renderer);
+    return 0;
+}
+#endif
+
+/* Draws the text in pieces of SPRITE_FONT_LAYOUT_MAX_LENGTH
+ * characters and stores its length. */
+static int sprite_font_draw_text(const Sprite_font *sprite_font,
+                                 SDL_Renderer *renderer,
+                                 Vec position,
+                                 Vec size,
+                                 SDL_Color color,
+                                 const char *text,
+                                 size_t *length)
+{
+    trace_assert(sprite_font);
+    trace_assert(text);
+    trace_assert(length);
+
+    *length = 0;
+    while (text[*length] != '\0') {
+        const Sprite_font_layout *layout = sprite_font_layout(sprite_font, text + *length, size);
+
+        if (sprite_font_draw_layout(sprite_font, renderer, layout, position, color) < 0) {
+            return -1;
+        }
+
+        position.x += (float) FONT_CHAR_WIDTH * (float) layout->length * size.x;
+        *length += layout->length;
+    }
+
+    return 0;
+}
+
 int sprite_font_render_text(const Sprite_font *sprite_font,
                             SDL_Renderer *renderer,
                             Vec position,
@@ -99,32 +356,44 @@ int sprite_font_render_text(const Sprite_font *sprite_font,
     trace_assert(text);
 
     const SDL_Color sdl_color = color_for_sdl(color);
+    size_t length = 0;
 
-    if (SDL_SetTextureColorMod(sprite_font->texture, sdl_color.r, sdl_color.g, sdl_color.b) < 0) {
-        log_fail("SDL_SetTextureColorMod: %s\n", SDL_GetError());
+    if (sprite_font_draw_begin(sprite_font, sdl_color) < 0 ||
+        sprite_font_draw_text(sprite_font, renderer, position, size, sdl_color, text, &length) < 0) {
         return -1;
     }
 
-    if (SDL_SetTextureAlphaMod(sprite_font->texture, sdl_color.a) < 0) {
-        log_fail("SDL_SetTextureAlphaMod: %s\n", SDL_GetError());
+    return sprite_font_draw_end(sprite_font, renderer);
+}
+
+int sprite_font_render_texts(const Sprite_font *sprite_font,
+                             SDL_Renderer *renderer,
+                             const Vec *positions,
+                             const char *texts,
+                             size_t count,
+                             Vec size,
+                             Color color)
+{
+    trace_assert(sprite_font);
+    trace_assert(renderer);
+    trace_assert(positions || count == 0);
+    trace_assert(texts || count == 0);
+
+    const SDL_Color sdl_color = color_for_sdl(color);
+
+    if (sprite_font_draw_begin(sprite_font, sdl_color) < 0) {
         return -1;
     }
 
-    const size_t text_size = strlen(text);
-    for (size_t i = 0; i < text_size; ++i) {
-        const SDL_Rect char_rect = sprite_font_char_rect(sprite_font, text[i]);
-        const SDL_Rect dest_rect = rect_for_sdl(
-            rect(
-                position.x + (float) FONT_CHAR_WIDTH * (float) i * size.x,
-                position.y,
-                (float) char_rect.w * size.x,
-                (float) char_rect.h * size.y));
-        if (SDL_RenderCopy(renderer, sprite_font->texture, &char_rect, &dest_rect) < 0) {
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = 0;
+        if (sprite_font_draw_text(sprite_font, renderer, positions[i], size, sdl_color, texts, &length) < 0) {
             return -1;
         }
+        texts += length + 1;
     }
 
-    return 0;
+    return sprite_font_draw_end(sprite_font, renderer);
 }
 
 Rect sprite_font_boundary_box(const Sprite_font *sprite_font,
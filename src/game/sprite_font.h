@@ -21,6 +21,19 @@ int sprite_font_render_text(const Sprite_font *sprite_font,
                             Color color,
                             const char *text);
 
+/** \brief Renders the texts of the same size and color together.
+ *
+ * The texts follow each other in one buffer, each terminated with
+ * '\0'. The i-th text is rendered at positions[i].
+ */
+int sprite_font_render_texts(const Sprite_font *sprite_font,
+                             SDL_Renderer *renderer,
+                             const Vec *positions,
+                             const char *texts,
+                             size_t count,
+                             Vec size,
+                             Color color);
+
 Rect sprite_font_boundary_box(const Sprite_font *sprite_font,
                               Vec position,
                               Vec size,
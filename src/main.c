@@ -20,6 +20,9 @@
 
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
+// Caps the amount of updates per frame when the game lags behind
+// the real time
+#define MAX_UPDATES_PER_FRAME 5
 
 static void print_usage(FILE *stream)
 {
@@ -151,10 +154,20 @@ int main(int argc, char *argv[])
 
     SDL_StopTextInput();
     SDL_Event e;
+    // The game is always updated with the same time step no matter
+    // how often it is rendered. The time that has not been simulated
+    // yet is accumulated and rendered as an interpolation between the
+    // last two updates.
     const int64_t delta_time = (int64_t) roundf(1000.0f / 60.0f);
-    int64_t render_timer = (int64_t) roundf(1000.0f / (float) fps);
+    const int64_t render_period = (int64_t) roundf(1000.0f / (float) fps);
+    int64_t accumulator = 0;
+    int64_t render_timer = 0;
+    int64_t previous_frame_time = (int64_t) SDL_GetTicks();
     while (!game_over_check(game)) {
         const int64_t begin_frame_time = (int64_t) SDL_GetTicks();
+        accumulator += begin_frame_time - previous_frame_time;
+        render_timer -= begin_frame_time - previous_frame_time;
+        previous_frame_time = begin_frame_time;
 
         while (!game_over_check(game) && SDL_PollEvent(&e)) {
             if (game_event(game, &e) < 0) {
@@ -162,29 +175,40 @@ int main(int argc, char *argv[])
             }
         }
 
-        if (game_input(game, keyboard_state, the_stick_of_joy) < 0) {
-            RETURN_LT(lt, -1);
-        }
+        int64_t updates = 0;
+        while (accumulator >= delta_time && updates < MAX_UPDATES_PER_FRAME) {
+            if (game_input(game, keyboard_state, the_stick_of_joy) < 0) {
+                RETURN_LT(lt, -1);
+            }
 
-        if (game_update(game, (float) delta_time * 0.001f) < 0) {
-            RETURN_LT(lt, -1);
+            if (game_update(game, (float) delta_time * 0.001f) < 0) {
+                RETURN_LT(lt, -1);
+            }
+
+            accumulator -= delta_time;
+            updates++;
         }
 
+        // The game could not catch up with the real time. Dropping
+        // the lag instead of running even more updates next frame.
+        accumulator %= delta_time;
+
         if (game_sound(game) < 0) {
             RETURN_LT(lt, -1);
         }
 
-        render_timer -= delta_time;
         if (render_timer <= 0) {
-            if (game_render(game) < 0) {
+            if (game_render(game, (float) accumulator / (float) delta_time) < 0) {
                 RETURN_LT(lt, -1);
             }
             SDL_RenderPresent(renderer);
-            render_timer = (int64_t) roundf(1000.0f / (float) fps);
+            render_timer = render_period;
         }
 
         const int64_t end_frame_time = (int64_t) SDL_GetTicks();
-        SDL_Delay((unsigned int) max_int64(10, delta_time - (end_frame_time - begin_frame_time)));
+        const int64_t next_update = delta_time - accumulator;
+        const int64_t next_event = next_update < render_timer ? next_update : render_timer;
+        SDL_Delay((unsigned int) max_int64(1, next_event - (end_frame_time - begin_frame_time)));
     }
 
     RETURN_LT(lt, 0);
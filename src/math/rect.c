@@ -222,3 +222,49 @@ Vec rect_impulse(Rect *r1, Rect *r2)
         return vec(1.0f, 0.0f);
     }
 }
+
+// The times the object enters and leaves the slab of the obstacle
+// along one axis
+static void rect_slab_times(float position, float size, float displacement,
+                            float obstacle_position, float obstacle_size,
+                            float *entry, float *exit)
+{
+    if (displacement > 0.0f) {
+        *entry = (obstacle_position - (position + size)) / displacement;
+        *exit = (obstacle_position + obstacle_size - position) / displacement;
+    } else if (displacement < 0.0f) {
+        *entry = (obstacle_position + obstacle_size - position) / displacement;
+        *exit = (obstacle_position - (position + size)) / displacement;
+    } else if (position < obstacle_position + obstacle_size &&
+               position + size > obstacle_position) {
+        *entry = -INFINITY;
+        *exit = INFINITY;
+    } else {
+        *entry = INFINITY;
+        *exit = -INFINITY;
+    }
+}
+
+float rect_time_of_impact(Rect object, Vec displacement, Rect obstacle, Vec *mask)
+{
+    trace_assert(mask);
+
+    float entry_x, exit_x, entry_y, exit_y;
+    rect_slab_times(object.x, object.w, displacement.x,
+                    obstacle.x, obstacle.w,
+                    &entry_x, &exit_x);
+    rect_slab_times(object.y, object.h, displacement.y,
+                    obstacle.y, obstacle.h,
+                    &entry_y, &exit_y);
+
+    const float entry = fmaxf(entry_x, entry_y);
+    const float exit = fminf(exit_x, exit_y);
+
+    if (entry >= exit || entry < 0.0f || entry > 1.0f) {
+        return INFINITY;
+    }
+
+    *mask = entry_x > entry_y ? vec(0.0f, 1.0f) : vec(1.0f, 0.0f);
+
+    return entry;
+}
@@ -51,4 +51,13 @@ Vec rect_center(Rect rect);
 Vec rect_snap(Rect pivot, Rect *rect);
 Vec rect_impulse(Rect *r1, Rect *r2);
 
+/** \brief Finds the fraction of displacement the object moves before it touches the obstacle.
+ *
+ * Returns a value in [0, 1], or INFINITY if the object misses the
+ * obstacle or overlaps it from the start. On a hit mask is set like
+ * rect_snap does: the velocity along the axis of the hit is zeroed
+ * by multiplying it with mask.
+ */
+float rect_time_of_impact(Rect object, Vec displacement, Rect obstacle, Vec *mask);
+
 #endif  // RECT_H_
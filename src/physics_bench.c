@@ -0,0 +1,295 @@
+#include <SDL2/SDL.h>
+#include "system/stacktrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color.h"
+#include "game/level/platforms.h"
+#include "game/level/rigid_bodies.h"
+#include "math/rand.h"
+#include "math/rect.h"
+#include "system/line_stream.h"
+#include "system/log.h"
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+
+#define PHYSICS_BENCH_LINE_MAX_LENGTH 512
+#define PHYSICS_BENCH_GRAVITY 1500.0f
+#define PHYSICS_BENCH_DELTA_TIME 0.016f
+#define PHYSICS_BENCH_BOX_SIZE 40.0f
+#define PHYSICS_BENCH_WORLD_SIZE 4000.0f
+
+/* Runs the physics of the level without a window:
+ *
+ *   physics_bench [--level <file>] [--bodies <n>] [--platforms <m>]
+ *                 [--frames <f>] [--broadphase <name>] [--threads <t>]
+ *                 [--solver-iterations <k>] [--seed <s>]
+ *
+ * With --level the platforms are taken from the level file,
+ * otherwise m random platforms are generated. The n boxes are
+ * dropped from random positions above the platforms. */
+
+typedef struct {
+    const char *level_file;
+    size_t bodies_count;
+    size_t platforms_count;
+    size_t frames_count;
+    RigidBodiesBroadphase broadphase;
+    size_t threads_count;
+    size_t solver_iterations;
+    unsigned int seed;
+} BenchConfig;
+
+static void print_usage(FILE *stream)
+{
+    fprintf(stream,
+            "Usage: physics_bench [--level <file>] [--bodies <n>] [--platforms <m>]\n"
+            "                     [--frames <f>] [--broadphase brute-force|grid|sweep-and-prune]\n"
+            "                     [--threads <t>] [--solver-iterations <k>] [--seed <s>]\n");
+}
+
+static int parse_count(const char *flag, const char *value, size_t *count)
+{
+    char *end = NULL;
+    const long int result = value == NULL ? 0 : strtol(value, &end, 10);
+    if (value == NULL || *end != '\0' || result <= 0) {
+        log_fail("%s expects a positive number\n", flag);
+        return -1;
+    }
+
+    *count = (size_t) result;
+    return 0;
+}
+
+static int parse_config(int argc, char *argv[], BenchConfig *config)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *flag = argv[i];
+        const char *value = i + 1 < argc ? argv[++i] : NULL;
+
+        if (strcmp(flag, "--level") == 0 && value != NULL) {
+            config->level_file = value;
+        } else if (strcmp(flag, "--bodies") == 0) {
+            if (parse_count(flag, value, &config->bodies_count) < 0) {
+                return -1;
+            }
+        } else if (strcmp(flag, "--platforms") == 0) {
+            if (parse_count(flag, value, &config->platforms_count) < 0) {
+                return -1;
+            }
+        } else if (strcmp(flag, "--frames") == 0) {
+            if (parse_count(flag, value, &config->frames_count) < 0) {
+                return -1;
+            }
+        } else if (strcmp(flag, "--threads") == 0) {
+            if (parse_count(flag, value, &config->threads_count) < 0) {
+                return -1;
+            }
+        } else if (strcmp(flag, "--solver-iterations") == 0) {
+            if (parse_count(flag, value, &config->solver_iterations) < 0) {
+                return -1;
+            }
+        } else if (strcmp(flag, "--seed") == 0) {
+            size_t seed = 0;
+            if (parse_count(flag, value, &seed) < 0) {
+                return -1;
+            }
+            config->seed = (unsigned int) seed;
+        } else if (strcmp(flag, "--broadphase") == 0 && value != NULL) {
+            if (strcmp(value, "brute-force") == 0) {
+                config->broadphase = RIGID_BODIES_BROADPHASE_BRUTE_FORCE;
+            } else if (strcmp(value, "grid") == 0) {
+                config->broadphase = RIGID_BODIES_BROADPHASE_GRID;
+            } else if (strcmp(value, "sweep-and-prune") == 0) {
+                config->broadphase = RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE;
+            } else {
+                log_fail("Unknown broadphase `%s`\n", value);
+                return -1;
+            }
+        } else {
+            print_usage(stderr);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* The platforms come in the level file after the background, the
+ * player and the player's script. */
+static Platforms *load_level_platforms(const char *level_file)
+{
+    trace_assert(level_file);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    LineStream *level_stream = PUSH_LT(
+        lt,
+        create_line_stream(level_file, "r", PHYSICS_BENCH_LINE_MAX_LENGTH),
+        destroy_line_stream);
+    if (level_stream == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    // Background and player
+    for (size_t i = 0; i < 2; ++i) {
+        if (line_stream_next(level_stream) == NULL) {
+            log_fail("Could not read the level `%s`\n", level_file);
+            RETURN_LT(lt, NULL);
+        }
+    }
+
+    const char *line = line_stream_next(level_stream);
+    size_t script_lines = 0;
+    if (line == NULL || sscanf(line, "%lu", &script_lines) == EOF) {
+        log_fail("Could not read the script of the level `%s`\n", level_file);
+        RETURN_LT(lt, NULL);
+    }
+
+    for (size_t i = 0; i < script_lines; ++i) {
+        if (line_stream_next(level_stream) == NULL) {
+            log_fail("Could not read the script of the level `%s`\n", level_file);
+            RETURN_LT(lt, NULL);
+        }
+    }
+
+    Platforms *platforms = create_platforms_from_line_stream(level_stream);
+
+    RETURN_LT(lt, platforms);
+}
+
+static Platforms *generate_platforms(size_t platforms_count)
+{
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    Rect *rects = PUSH_LT(lt, nth_calloc(platforms_count + 1, sizeof(Rect)), free);
+    if (rects == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    Color *colors = PUSH_LT(lt, nth_calloc(platforms_count + 1, sizeof(Color)), free);
+    if (colors == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    const float half = PHYSICS_BENCH_WORLD_SIZE * 0.5f;
+
+    // The floor keeps the boxes in the world, the rest are ledges
+    rects[0] = rect(-half, half, PHYSICS_BENCH_WORLD_SIZE, 100.0f);
+    colors[0] = hexstr("483737");
+    for (size_t i = 1; i < platforms_count; ++i) {
+        rects[i] = rect(
+            rand_float_range(-half, half),
+            rand_float_range(-half, half),
+            rand_float_range(50.0f, 500.0f),
+            rand_float_range(10.0f, 100.0f));
+        colors[i] = hexstr("483737");
+    }
+
+    Platforms *platforms = create_platforms(rects, colors, platforms_count);
+
+    RETURN_LT(lt, platforms);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config = {
+        .level_file = NULL,
+        .bodies_count = 1000,
+        .platforms_count = 100,
+        .frames_count = 600,
+        .broadphase = RIGID_BODIES_BROADPHASE_SWEEP_AND_PRUNE,
+        .threads_count = 1,
+        .solver_iterations = 0,
+        .seed = 1
+    };
+
+    if (parse_config(argc, argv, &config) < 0) {
+        return -1;
+    }
+
+    srand(config.seed);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return -1;
+    }
+
+    Platforms *platforms = PUSH_LT(
+        lt,
+        (config.level_file != NULL
+         ? load_level_platforms(config.level_file)
+         : generate_platforms(config.platforms_count)),
+        destroy_platforms);
+    if (platforms == NULL) {
+        RETURN_LT(lt, -1);
+    }
+
+    RigidBodies *rigid_bodies = PUSH_LT(
+        lt,
+        create_rigid_bodies(config.bodies_count),
+        destroy_rigid_bodies);
+    if (rigid_bodies == NULL) {
+        RETURN_LT(lt, -1);
+    }
+
+    rigid_bodies_set_broadphase(rigid_bodies, config.broadphase);
+    if (config.solver_iterations > 0) {
+        rigid_bodies_set_solver_iterations(rigid_bodies, config.solver_iterations);
+    }
+    if (rigid_bodies_set_threads_count(rigid_bodies, config.threads_count) < 0) {
+        RETURN_LT(lt, -1);
+    }
+
+    // The boxes are dropped from above the platforms so they pile up
+    const float half = PHYSICS_BENCH_WORLD_SIZE * 0.5f;
+    for (size_t i = 0; i < config.bodies_count; ++i) {
+        rigid_bodies_add(
+            rigid_bodies,
+            rect(
+                rand_float_range(-half, half - PHYSICS_BENCH_BOX_SIZE),
+                rand_float_range(-PHYSICS_BENCH_WORLD_SIZE, -half),
+                PHYSICS_BENCH_BOX_SIZE,
+                PHYSICS_BENCH_BOX_SIZE),
+            rgba(1.0f, 0.0f, 0.0f, 1.0f));
+    }
+
+    size_t contacts = 0;
+    size_t collisions = 0;
+    size_t solver_iterations = 0;
+
+    const Uint64 begin = SDL_GetPerformanceCounter();
+    for (size_t frame = 0; frame < config.frames_count; ++frame) {
+        rigid_bodies_apply_omniforce(rigid_bodies, vec(0.0f, PHYSICS_BENCH_GRAVITY));
+        rigid_bodies_integrate_all(rigid_bodies, PHYSICS_BENCH_DELTA_TIME);
+        if (rigid_bodies_collide(rigid_bodies, platforms) < 0) {
+            RETURN_LT(lt, -1);
+        }
+
+        const RigidBodiesStats stats = rigid_bodies_stats(rigid_bodies);
+        contacts += stats.contacts;
+        collisions += stats.collisions;
+        solver_iterations += stats.solver_iterations;
+    }
+    const Uint64 end = SDL_GetPerformanceCounter();
+
+    const double frames = (double) config.frames_count;
+    const double ns_per_step =
+        (double) (end - begin) * 1e9 / (double) SDL_GetPerformanceFrequency() / frames;
+
+    printf("bodies: %lu\n", config.bodies_count);
+    printf("frames: %lu\n", config.frames_count);
+    printf("ns/step: %.0f\n", ns_per_step);
+    printf("contacts/step: %.2f\n", (double) contacts / frames);
+    printf("collisions/step: %.2f\n", (double) collisions / frames);
+    printf("solver iterations/step: %.2f\n", (double) solver_iterations / frames);
+
+    RETURN_LT(lt, 0);
+}
@@ -0,0 +1,259 @@
+#include <SDL2/SDL.h>
+#include "system/stacktrace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "math/rand.h"
+#include "math/triangle.h"
+#include "sdl/renderer.h"
+#include "system/log.h"
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+
+/* Fills the triangles of explosions and goals on an offscreen surface
+ * with the scanline path and with fill_triangles:
+ *
+ *   render_bench [--triangles <n>] [--size <s>] [--frames <f>]
+ *                [--width <w>] [--height <h>] [--seed <s>]
+ *
+ * and reports the time per frame of both. The draw calls per frame
+ * are not counted but estimated from the triangles. */
+
+typedef struct {
+    size_t triangles_count;
+    size_t triangle_size;
+    size_t frames_count;
+    size_t width;
+    size_t height;
+    unsigned int seed;
+} BenchConfig;
+
+static void print_usage(FILE *stream)
+{
+    fprintf(stream,
+            "Usage: render_bench [--triangles <n>] [--size <s>] [--frames <f>]\n"
+            "                    [--width <w>] [--height <h>] [--seed <s>]\n");
+}
+
+static int parse_count(const char *flag, const char *value, size_t *count)
+{
+    char *end = NULL;
+    const long int result = value == NULL ? 0 : strtol(value, &end, 10);
+    if (value == NULL || *end != '\0' || result <= 0) {
+        log_fail("%s expects a positive number\n", flag);
+        return -1;
+    }
+
+    *count = (size_t) result;
+    return 0;
+}
+
+static int parse_config(int argc, char *argv[], BenchConfig *config)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *flag = argv[i];
+        const char *value = i + 1 < argc ? argv[++i] : NULL;
+        size_t *count = NULL;
+
+        if (strcmp(flag, "--triangles") == 0) {
+            count = &config->triangles_count;
+        } else if (strcmp(flag, "--size") == 0) {
+            count = &config->triangle_size;
+        } else if (strcmp(flag, "--frames") == 0) {
+            count = &config->frames_count;
+        } else if (strcmp(flag, "--width") == 0) {
+            count = &config->width;
+        } else if (strcmp(flag, "--height") == 0) {
+            count = &config->height;
+        } else if (strcmp(flag, "--seed") == 0) {
+            size_t seed = 0;
+            if (parse_count(flag, value, &seed) < 0) {
+                return -1;
+            }
+            config->seed = (unsigned int) seed;
+            continue;
+        } else {
+            print_usage(stderr);
+            return -1;
+        }
+
+        if (parse_count(flag, value, count) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int fill_triangles_scanline(SDL_Renderer *renderer,
+                                   const Triangle *ts,
+                                   const SDL_Color *colors,
+                                   size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (SDL_SetRenderDrawColor(renderer, colors[i].r, colors[i].g, colors[i].b, colors[i].a) < 0) {
+            log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
+            return -1;
+        }
+
+        if (fill_triangle(renderer, ts[i]) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* The scanline path issues about one draw call per row of every
+ * triangle and one more to set its color. */
+static size_t estimate_scanline_calls(const Triangle *ts, size_t count)
+{
+    size_t calls = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Triangle t = triangle_sorted_by_y(ts[i]);
+        calls += (size_t) (roundf(t.p3.y) - roundf(t.p1.y)) + 2;
+    }
+    return calls;
+}
+
+static size_t estimate_geometry_calls(const Triangle *ts, size_t count)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    (void) ts;
+    return (count + FILL_TRIANGLES_CHUNK_SIZE - 1) / FILL_TRIANGLES_CHUNK_SIZE;
+#else
+    return estimate_scanline_calls(ts, count);
+#endif
+}
+
+typedef int (*FillTriangles)(SDL_Renderer *renderer,
+                             const Triangle *ts,
+                             const SDL_Color *colors,
+                             size_t count);
+
+static int bench_path(const char *name,
+                      FillTriangles fill,
+                      size_t estimated_calls,
+                      SDL_Renderer *renderer,
+                      const Triangle *ts,
+                      const SDL_Color *colors,
+                      const BenchConfig *config)
+{
+    const Uint64 begin = SDL_GetPerformanceCounter();
+    for (size_t frame = 0; frame < config->frames_count; ++frame) {
+        if (SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255) < 0 ||
+            SDL_RenderClear(renderer) < 0) {
+            log_fail("SDL_RenderClear: %s\n", SDL_GetError());
+            return -1;
+        }
+
+        if (fill(renderer, ts, colors, config->triangles_count) < 0) {
+            return -1;
+        }
+    }
+    const Uint64 end = SDL_GetPerformanceCounter();
+
+    const double us_per_frame =
+        (double) (end - begin) * 1e6 / (double) SDL_GetPerformanceFrequency()
+        / (double) config->frames_count;
+
+    printf("%s: %.1f us/frame, ~%lu calls/frame (estimated)\n",
+           name, us_per_frame, estimated_calls);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config = {
+        .triangles_count = 100,
+        .triangle_size = 20,
+        .frames_count = 1000,
+        .width = 1920,
+        .height = 1080,
+        .seed = 1
+    };
+
+    if (parse_config(argc, argv, &config) < 0) {
+        return -1;
+    }
+
+    srand(config.seed);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return -1;
+    }
+
+    SDL_Surface *surface = PUSH_LT(
+        lt,
+        SDL_CreateRGBSurfaceWithFormat(
+            0, (int) config.width, (int) config.height, 32,
+            SDL_PIXELFORMAT_RGBA8888),
+        SDL_FreeSurface);
+    if (surface == NULL) {
+        log_fail("SDL_CreateRGBSurfaceWithFormat: %s\n", SDL_GetError());
+        RETURN_LT(lt, -1);
+    }
+
+    SDL_Renderer *renderer = PUSH_LT(
+        lt,
+        SDL_CreateSoftwareRenderer(surface),
+        SDL_DestroyRenderer);
+    if (renderer == NULL) {
+        log_fail("SDL_CreateSoftwareRenderer: %s\n", SDL_GetError());
+        RETURN_LT(lt, -1);
+    }
+
+    if (SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND) < 0) {
+        log_fail("SDL_SetRenderDrawBlendMode: %s\n", SDL_GetError());
+        RETURN_LT(lt, -1);
+    }
+
+    Triangle *ts = PUSH_LT(lt, nth_calloc(config.triangles_count, sizeof(Triangle)), free);
+    if (ts == NULL) {
+        RETURN_LT(lt, -1);
+    }
+
+    SDL_Color *colors = PUSH_LT(lt, nth_calloc(config.triangles_count, sizeof(SDL_Color)), free);
+    if (colors == NULL) {
+        RETURN_LT(lt, -1);
+    }
+
+    const float size = (float) config.triangle_size;
+    for (size_t i = 0; i < config.triangles_count; ++i) {
+        const Triangle t = random_triangle(size);
+        const Vec offset = vec(
+            rand_float_range(size, (float) config.width - size),
+            rand_float_range(size, (float) config.height - size));
+        ts[i] = triangle(
+            vec_sum(t.p1, offset),
+            vec_sum(t.p2, offset),
+            vec_sum(t.p3, offset));
+        colors[i] = (SDL_Color) {
+            (Uint8) (rand() % 256),
+            (Uint8) (rand() % 256),
+            (Uint8) (rand() % 256),
+            (Uint8) (rand() % 256)
+        };
+    }
+
+    printf("triangles: %lu\n", config.triangles_count);
+    printf("frames: %lu\n", config.frames_count);
+
+    if (bench_path("scanline", fill_triangles_scanline,
+                   estimate_scanline_calls(ts, config.triangles_count),
+                   renderer, ts, colors, &config) < 0) {
+        RETURN_LT(lt, -1);
+    }
+
+    if (bench_path("geometry", fill_triangles,
+                   estimate_geometry_calls(ts, config.triangles_count),
+                   renderer, ts, colors, &config) < 0) {
+        RETURN_LT(lt, -1);
+    }
+
+    RETURN_LT(lt, 0);
+}
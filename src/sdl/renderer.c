@@ -135,6 +135,65 @@ int fill_triangle(SDL_Renderer *render,
     return 0;
 }
 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+int fill_triangles(SDL_Renderer *render,
+                   const Triangle *ts,
+                   const SDL_Color *colors,
+                   size_t count)
+{
+    trace_assert(render);
+    trace_assert(ts || count == 0);
+    trace_assert(colors || count == 0);
+
+    SDL_Vertex vertices[FILL_TRIANGLES_CHUNK_SIZE * 3];
+
+    for (size_t begin = 0; begin < count; begin += FILL_TRIANGLES_CHUNK_SIZE) {
+        const size_t n = count - begin < FILL_TRIANGLES_CHUNK_SIZE
+            ? count - begin
+            : FILL_TRIANGLES_CHUNK_SIZE;
+
+        for (size_t i = 0; i < n; ++i) {
+            const Triangle t = ts[begin + i];
+            const SDL_Color c = colors[begin + i];
+            vertices[i * 3 + 0] = (SDL_Vertex) { { t.p1.x, t.p1.y }, c, { 0.0f, 0.0f } };
+            vertices[i * 3 + 1] = (SDL_Vertex) { { t.p2.x, t.p2.y }, c, { 0.0f, 0.0f } };
+            vertices[i * 3 + 2] = (SDL_Vertex) { { t.p3.x, t.p3.y }, c, { 0.0f, 0.0f } };
+        }
+
+        if (SDL_RenderGeometry(render, NULL, vertices, (int) (n * 3), NULL, 0) < 0) {
+            log_fail("SDL_RenderGeometry: %s\n", SDL_GetError());
+            return -1;
+        }
+    }
+
+    return 0;
+}
+#else
+int fill_triangles(SDL_Renderer *render,
+                   const Triangle *ts,
+                   const SDL_Color *colors,
+                   size_t count)
+{
+    trace_assert(render);
+    trace_assert(ts || count == 0);
+    trace_assert(colors || count == 0);
+
+    for (size_t i = 0; i < count; ++i) {
+        const SDL_Color c = colors[i];
+        if (SDL_SetRenderDrawColor(render, c.r, c.g, c.b, c.a) < 0) {
+            log_fail("SDL_SetRenderDrawColor: %s\n", SDL_GetError());
+            return -1;
+        }
+
+        if (fill_triangle(render, ts[i]) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
 int fill_rect(SDL_Renderer *render, Rect r, Color c)
 {
     const SDL_Rect sdl_rect = rect_for_sdl(r);
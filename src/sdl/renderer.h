@@ -14,6 +14,20 @@ int draw_triangle(SDL_Renderer *render,
 int fill_triangle(SDL_Renderer *render,
                   Triangle t);
 
+// The amount of triangles fill_triangles submits in one call
+#define FILL_TRIANGLES_CHUNK_SIZE 256
+
+/** \brief Fills the triangles, each with its own color.
+ *
+ * With SDL 2.0.18 or newer the triangles are submitted with
+ * SDL_RenderGeometry in one call per FILL_TRIANGLES_CHUNK_SIZE
+ * triangles. Older SDL falls back to fill_triangle.
+ */
+int fill_triangles(SDL_Renderer *render,
+                   const Triangle *ts,
+                   const SDL_Color *colors,
+                   size_t count);
+
 int fill_rect(SDL_Renderer *render,
               Rect r,
               Color c);
@@ -0,0 +1,154 @@
+#include <SDL2/SDL.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "system/log.h"
+#include "system/lt.h"
+#include "system/nth_alloc.h"
+#include "system/stacktrace.h"
+#include "./worker_pool.h"
+
+struct WorkerPool
+{
+    Lt *lt;
+    size_t threads_count;
+    SDL_Thread **threads;
+    SDL_sem *start;
+    SDL_sem *done;
+    bool quit;
+
+    WorkerPoolJob job;
+    void *param;
+    size_t count;
+    SDL_atomic_t next;
+};
+
+static void worker_pool_work(WorkerPool *worker_pool)
+{
+    trace_assert(worker_pool);
+
+    for (;;) {
+        const size_t index = (size_t) SDL_AtomicAdd(&worker_pool->next, 1);
+        if (index >= worker_pool->count) {
+            return;
+        }
+
+        worker_pool->job(worker_pool->param, index);
+    }
+}
+
+static int worker_pool_thread(void *data)
+{
+    WorkerPool *worker_pool = data;
+    trace_assert(worker_pool);
+
+    for (;;) {
+        SDL_SemWait(worker_pool->start);
+
+        if (worker_pool->quit) {
+            return 0;
+        }
+
+        worker_pool_work(worker_pool);
+        SDL_SemPost(worker_pool->done);
+    }
+}
+
+WorkerPool *create_worker_pool(size_t threads_count)
+{
+    trace_assert(threads_count > 0);
+
+    Lt *lt = create_lt();
+    if (lt == NULL) {
+        return NULL;
+    }
+
+    WorkerPool *worker_pool = PUSH_LT(lt, nth_calloc(1, sizeof(WorkerPool)), free);
+    if (worker_pool == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+    worker_pool->lt = lt;
+
+    worker_pool->start = PUSH_LT(lt, SDL_CreateSemaphore(0), SDL_DestroySemaphore);
+    if (worker_pool->start == NULL) {
+        log_fail("SDL_CreateSemaphore: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    worker_pool->done = PUSH_LT(lt, SDL_CreateSemaphore(0), SDL_DestroySemaphore);
+    if (worker_pool->done == NULL) {
+        log_fail("SDL_CreateSemaphore: %s\n", SDL_GetError());
+        RETURN_LT(lt, NULL);
+    }
+
+    worker_pool->threads = PUSH_LT(lt, nth_calloc(threads_count, sizeof(SDL_Thread*)), free);
+    if (worker_pool->threads == NULL) {
+        RETURN_LT(lt, NULL);
+    }
+
+    // The calling thread is the first worker
+    worker_pool->threads_count = 1;
+    while (worker_pool->threads_count < threads_count) {
+        SDL_Thread *thread = SDL_CreateThread(worker_pool_thread, "worker", worker_pool);
+        if (thread == NULL) {
+            log_fail("SDL_CreateThread: %s\n", SDL_GetError());
+            destroy_worker_pool(worker_pool);
+            return NULL;
+        }
+
+        worker_pool->threads[worker_pool->threads_count++] = thread;
+    }
+
+    return worker_pool;
+}
+
+void destroy_worker_pool(WorkerPool *worker_pool)
+{
+    trace_assert(worker_pool);
+
+    worker_pool->quit = true;
+
+    for (size_t i = 1; i < worker_pool->threads_count; ++i) {
+        SDL_SemPost(worker_pool->start);
+    }
+
+    for (size_t i = 1; i < worker_pool->threads_count; ++i) {
+        SDL_WaitThread(worker_pool->threads[i], NULL);
+    }
+
+    RETURN_LT0(worker_pool->lt);
+}
+
+size_t worker_pool_threads_count(const WorkerPool *worker_pool)
+{
+    trace_assert(worker_pool);
+    return worker_pool->threads_count;
+}
+
+void worker_pool_run(WorkerPool *worker_pool,
+                     WorkerPoolJob job,
+                     void *param,
+                     size_t count)
+{
+    trace_assert(worker_pool);
+    trace_assert(job);
+    trace_assert(count <= INT_MAX);
+
+    worker_pool->job = job;
+    worker_pool->param = param;
+    worker_pool->count = count;
+    SDL_AtomicSet(&worker_pool->next, 0);
+
+    // The semaphores order the writes above before the work of the
+    // threads and the work of the threads before the return
+    for (size_t i = 1; i < worker_pool->threads_count; ++i) {
+        SDL_SemPost(worker_pool->start);
+    }
+
+    worker_pool_work(worker_pool);
+
+    for (size_t i = 1; i < worker_pool->threads_count; ++i) {
+        SDL_SemWait(worker_pool->done);
+    }
+}
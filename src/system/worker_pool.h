@@ -0,0 +1,32 @@
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <stddef.h>
+
+typedef struct WorkerPool WorkerPool;
+
+/** \brief Job of worker_pool_run. Called once for every index.
+ */
+typedef void (*WorkerPoolJob)(void *param, size_t index);
+
+/** \brief Creates a pool of threads_count - 1 threads.
+ *
+ * The thread that calls worker_pool_run is the last worker.
+ */
+WorkerPool *create_worker_pool(size_t threads_count);
+void destroy_worker_pool(WorkerPool *worker_pool);
+
+size_t worker_pool_threads_count(const WorkerPool *worker_pool);
+
+/** \brief Calls job for every index in [0, count) across the workers
+ * and waits for all of them to finish.
+ *
+ * The order in which the indices are picked up is not specified, so
+ * the jobs must not depend on each other.
+ */
+void worker_pool_run(WorkerPool *worker_pool,
+                     WorkerPoolJob job,
+                     void *param,
+                     size_t count);
+
+#endif  // WORKER_POOL_H_
@@ -0,0 +1,241 @@
+#ifndef AABB_TREE_SUITE_H_
+#define AABB_TREE_SUITE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "aabb_tree.h"
+#include "math/rand.h"
+
+#define AABB_TREE_SUITE_RECTS_COUNT 200
+
+static void aabb_tree_suite_random_rects(Rect *rects, size_t count)
+{
+    srand(42);
+    for (size_t i = 0; i < count; ++i) {
+        rects[i] = rect(
+            rand_float_range(-500.0f, 500.0f),
+            rand_float_range(-500.0f, 500.0f),
+            rand_float_range(1.0f, 50.0f),
+            rand_float_range(1.0f, 50.0f));
+    }
+}
+
+typedef struct {
+    bool *visited;
+    size_t count;
+} Aabb_tree_suite_visits;
+
+static int aabb_tree_suite_visit(void *param, size_t index)
+{
+    Aabb_tree_suite_visits *visits = param;
+    if (visits->visited[index]) {
+        return -1;
+    }
+    visits->visited[index] = true;
+    visits->count++;
+    return 0;
+}
+
+TEST(aabb_tree_query_test)
+{
+    Rect rects[AABB_TREE_SUITE_RECTS_COUNT];
+    aabb_tree_suite_random_rects(rects, AABB_TREE_SUITE_RECTS_COUNT);
+
+    AabbTree *aabb_tree = create_aabb_tree(rects, AABB_TREE_SUITE_RECTS_COUNT);
+    ASSERT_TRUE(aabb_tree != NULL, {});
+
+    const Rect areas[] = {
+        rect(-100.0f, -100.0f, 200.0f, 200.0f),
+        rect(0.0f, 0.0f, 1.0f, 1.0f),
+        rect(-1000.0f, -1000.0f, 2000.0f, 2000.0f),
+        rect(2000.0f, 2000.0f, 10.0f, 10.0f)
+    };
+
+    for (size_t a = 0; a < sizeof(areas) / sizeof(areas[0]); ++a) {
+        bool visited[AABB_TREE_SUITE_RECTS_COUNT] = { false };
+        Aabb_tree_suite_visits visits = {
+            .visited = visited,
+            .count = 0
+        };
+
+        ASSERT_TRUE(aabb_tree_query(aabb_tree, areas[a], aabb_tree_suite_visit, &visits) == 0, {
+            fprintf(stderr, "Area %lu visited the same rect twice\n", a);
+        });
+
+        for (size_t i = 0; i < AABB_TREE_SUITE_RECTS_COUNT; ++i) {
+            ASSERT_TRUE(visited[i] == (rects_overlap(rects[i], areas[a]) != 0), {
+                fprintf(stderr, "Area %lu, rect %lu\n", a, i);
+            });
+        }
+    }
+
+    destroy_aabb_tree(aabb_tree);
+
+    return 0;
+}
+
+TEST(aabb_tree_raycast_test)
+{
+    const Rect rects[] = {
+        rect(10.0f, -5.0f, 10.0f, 10.0f),
+        rect(30.0f, -5.0f, 10.0f, 10.0f),
+        rect(-5.0f, -5.0f, 10.0f, 10.0f),
+        rect(10.0f, 50.0f, 10.0f, 10.0f)
+    };
+
+    AabbTree *aabb_tree = create_aabb_tree(rects, 4);
+    ASSERT_TRUE(aabb_tree != NULL, {});
+
+    size_t index = 0;
+    float t = 0.0f;
+
+    // The rect 2 contains the beginning of the ray and is not hit
+    ASSERT_TRUE(aabb_tree_raycast(aabb_tree, vec(0.0f, 0.0f), vec(100.0f, 0.0f),
+                                  NULL, NULL, &index, &t), {});
+    ASSERT_EQ(size_t, 0, index, {
+        fprintf(stderr, "Hit %lu instead of 0\n", index);
+    });
+    ASSERT_FLOATEQ(0.1f, t, 1e-4f);
+
+    ASSERT_TRUE(aabb_tree_raycast(aabb_tree, vec(100.0f, 0.0f), vec(0.0f, 0.0f),
+                                  NULL, NULL, &index, &t), {});
+    ASSERT_EQ(size_t, 1, index, {
+        fprintf(stderr, "Hit %lu instead of 1\n", index);
+    });
+    ASSERT_FLOATEQ(0.6f, t, 1e-4f);
+
+    // Too short to reach anything
+    ASSERT_FALSE(aabb_tree_raycast(aabb_tree, vec(0.0f, 0.0f), vec(8.0f, 0.0f),
+                                   NULL, NULL, &index, &t), {});
+
+    ASSERT_FALSE(aabb_tree_raycast(aabb_tree, vec(0.0f, 20.0f), vec(100.0f, 20.0f),
+                                   NULL, NULL, &index, &t), {});
+
+    destroy_aabb_tree(aabb_tree);
+
+    return 0;
+}
+
+static bool aabb_tree_suite_only_index(void *param, size_t index)
+{
+    return index == *(const size_t*) param;
+}
+
+TEST(aabb_tree_nearest_test)
+{
+    Rect rects[AABB_TREE_SUITE_RECTS_COUNT];
+    aabb_tree_suite_random_rects(rects, AABB_TREE_SUITE_RECTS_COUNT);
+
+    AabbTree *aabb_tree = create_aabb_tree(rects, AABB_TREE_SUITE_RECTS_COUNT);
+    ASSERT_TRUE(aabb_tree != NULL, {});
+
+    srand(69);
+    for (size_t k = 0; k < 100; ++k) {
+        const Vec point = vec(
+            rand_float_range(-600.0f, 600.0f),
+            rand_float_range(-600.0f, 600.0f));
+
+        // Brute force
+        float best = INFINITY;
+        for (size_t i = 0; i < AABB_TREE_SUITE_RECTS_COUNT; ++i) {
+            const float dx = fmaxf(fmaxf(rects[i].x - point.x, 0.0f), point.x - (rects[i].x + rects[i].w));
+            const float dy = fmaxf(fmaxf(rects[i].y - point.y, 0.0f), point.y - (rects[i].y + rects[i].h));
+            best = fminf(best, dx * dx + dy * dy);
+        }
+
+        size_t index = 0;
+        ASSERT_TRUE(aabb_tree_nearest(aabb_tree, point, NULL, NULL, &index), {});
+
+        const float dx = fmaxf(fmaxf(rects[index].x - point.x, 0.0f), point.x - (rects[index].x + rects[index].w));
+        const float dy = fmaxf(fmaxf(rects[index].y - point.y, 0.0f), point.y - (rects[index].y + rects[index].h));
+        const float distance = dx * dx + dy * dy;
+        ASSERT_FLOATEQ(best, distance, 1e-3f);
+    }
+
+    // The rect that contains the point is the nearest one
+    size_t index = 0;
+    const Vec center = rect_center(rects[42]);
+    ASSERT_TRUE(aabb_tree_nearest(aabb_tree, center, NULL, NULL, &index), {});
+    ASSERT_TRUE(rect_contains_point(rects[index], center), {
+        fprintf(stderr, "Found %lu that does not contain the point\n", index);
+    });
+
+    // The filter leaves only one rect to find
+    size_t only = 17;
+    ASSERT_TRUE(aabb_tree_nearest(aabb_tree, vec(1000.0f, 1000.0f),
+                                  aabb_tree_suite_only_index, &only, &index), {});
+    ASSERT_EQ(size_t, only, index, {
+        fprintf(stderr, "Found %lu instead of %lu\n", index, only);
+    });
+
+    destroy_aabb_tree(aabb_tree);
+
+    return 0;
+}
+
+TEST(aabb_tree_refit_test)
+{
+    Rect rects[AABB_TREE_SUITE_RECTS_COUNT];
+    aabb_tree_suite_random_rects(rects, AABB_TREE_SUITE_RECTS_COUNT);
+
+    AabbTree *aabb_tree = create_aabb_tree(rects, AABB_TREE_SUITE_RECTS_COUNT);
+    ASSERT_TRUE(aabb_tree != NULL, {});
+
+    // Scatter the rects far from where the tree was built
+    srand(1337);
+    for (size_t i = 0; i < AABB_TREE_SUITE_RECTS_COUNT; ++i) {
+        rects[i].x = rand_float_range(-2000.0f, 2000.0f);
+        rects[i].y = rand_float_range(-2000.0f, 2000.0f);
+    }
+    aabb_tree_refit(aabb_tree, rects, AABB_TREE_SUITE_RECTS_COUNT);
+
+    const Rect area = rect(-500.0f, -500.0f, 1000.0f, 1000.0f);
+    bool visited[AABB_TREE_SUITE_RECTS_COUNT] = { false };
+    Aabb_tree_suite_visits visits = {
+        .visited = visited,
+        .count = 0
+    };
+
+    ASSERT_TRUE(aabb_tree_query(aabb_tree, area, aabb_tree_suite_visit, &visits) == 0, {});
+    for (size_t i = 0; i < AABB_TREE_SUITE_RECTS_COUNT; ++i) {
+        ASSERT_TRUE(visited[i] == (rects_overlap(rects[i], area) != 0), {
+            fprintf(stderr, "Rect %lu\n", i);
+        });
+    }
+
+    destroy_aabb_tree(aabb_tree);
+
+    return 0;
+}
+
+TEST(aabb_tree_empty_test)
+{
+    AabbTree *aabb_tree = create_aabb_tree(NULL, 0);
+    ASSERT_TRUE(aabb_tree != NULL, {});
+
+    size_t index = 0;
+    float t = 0.0f;
+    ASSERT_FALSE(aabb_tree_raycast(aabb_tree, vec(0.0f, 0.0f), vec(1.0f, 1.0f),
+                                   NULL, NULL, &index, &t), {});
+    ASSERT_FALSE(aabb_tree_nearest(aabb_tree, vec(0.0f, 0.0f), NULL, NULL, &index), {});
+
+    destroy_aabb_tree(aabb_tree);
+
+    return 0;
+}
+
+TEST_SUITE(aabb_tree_suite)
+{
+    TEST_RUN(aabb_tree_query_test);
+    TEST_RUN(aabb_tree_raycast_test);
+    TEST_RUN(aabb_tree_nearest_test);
+    TEST_RUN(aabb_tree_refit_test);
+    TEST_RUN(aabb_tree_empty_test);
+
+    return 0;
+}
+
+#endif  // AABB_TREE_SUITE_H_
@@ -0,0 +1,161 @@
+#ifndef BROADPHASE_SUITE_H_
+#define BROADPHASE_SUITE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "game/level/rigid_bodies/spatial_grid.h"
+#include "game/level/rigid_bodies/sweep_and_prune.h"
+#include "math/rand.h"
+
+#define BROADPHASE_SUITE_RECTS_COUNT 150
+#define BROADPHASE_SUITE_MARGIN 4.0f
+
+static void broadphase_suite_random_rects(Rect *rects, bool *skip, bool *still, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        rects[i] = rect(
+            rand_float_range(0.0f, 400.0f),
+            rand_float_range(0.0f, 400.0f),
+            rand_float_range(1.0f, 60.0f),
+            rand_float_range(1.0f, 60.0f));
+        skip[i] = rand() % 10 == 0;
+        still[i] = rand() % 3 == 0;
+    }
+}
+
+/* Checks the pairs against all of the pairs of the rects that are
+ * closer than margin, except the pairs of two still rects */
+static int broadphase_suite_check_pairs(const Rect *rects,
+                                        const bool *skip,
+                                        const bool *still,
+                                        size_t count,
+                                        float margin,
+                                        const size_t *pairs,
+                                        size_t pairs_count)
+{
+    static bool found[BROADPHASE_SUITE_RECTS_COUNT][BROADPHASE_SUITE_RECTS_COUNT];
+    memset(found, 0, sizeof(found));
+
+    for (size_t k = 0; k < pairs_count; ++k) {
+        const size_t i1 = pairs[2 * k];
+        const size_t i2 = pairs[2 * k + 1];
+
+        ASSERT_TRUE(i1 < i2 && i2 < count, {
+            fprintf(stderr, "Bad pair (%lu, %lu)\n", i1, i2);
+        });
+        ASSERT_FALSE(found[i1][i2], {
+            fprintf(stderr, "Pair (%lu, %lu) is found twice\n", i1, i2);
+        });
+        found[i1][i2] = true;
+    }
+
+    for (size_t i1 = 0; i1 < count; ++i1) {
+        const Rect r1 = rect(rects[i1].x - margin,
+                             rects[i1].y - margin,
+                             rects[i1].w + margin * 2.0f,
+                             rects[i1].h + margin * 2.0f);
+
+        for (size_t i2 = i1 + 1; i2 < count; ++i2) {
+            const bool expected =
+                !skip[i1] && !skip[i2] &&
+                !(still[i1] && still[i2]) &&
+                rects_overlap(r1, rects[i2]);
+            ASSERT_TRUE(found[i1][i2] == expected, {
+                fprintf(stderr, "Pair (%lu, %lu) is %s\n", i1, i2,
+                        expected ? "missing" : "not expected");
+            });
+        }
+    }
+
+    return 0;
+}
+
+TEST(spatial_grid_pairs_test)
+{
+    SpatialGrid *grid = create_spatial_grid(32.0f);
+    ASSERT_TRUE(grid != NULL, {});
+
+    Rect rects[BROADPHASE_SUITE_RECTS_COUNT];
+    bool skip[BROADPHASE_SUITE_RECTS_COUNT];
+    bool still[BROADPHASE_SUITE_RECTS_COUNT];
+
+    srand(42);
+    for (size_t step = 0; step < 5; ++step) {
+        broadphase_suite_random_rects(rects, skip, still, BROADPHASE_SUITE_RECTS_COUNT);
+
+        // The rects that span too many cells are checked separately
+        for (size_t i = 0; i < 4; ++i) {
+            rects[i].w = 300.0f;
+            rects[i].h = 300.0f;
+            skip[i] = false;
+            still[i] = i % 2 == 0;
+        }
+
+        const float margin = step % 2 == 0 ? 0.0f : BROADPHASE_SUITE_MARGIN;
+        const size_t *pairs = NULL;
+        size_t pairs_count = 0;
+        ASSERT_TRUE(spatial_grid_find_pairs(grid, rects, skip, still, BROADPHASE_SUITE_RECTS_COUNT,
+                                            margin, &pairs, &pairs_count) == 0, {});
+
+        if (broadphase_suite_check_pairs(rects, skip, still, BROADPHASE_SUITE_RECTS_COUNT,
+                                         margin, pairs, pairs_count) < 0) {
+            return -1;
+        }
+    }
+
+    destroy_spatial_grid(grid);
+
+    return 0;
+}
+
+TEST(sweep_and_prune_pairs_test)
+{
+    SweepAndPrune *sweep_and_prune = create_sweep_and_prune();
+    ASSERT_TRUE(sweep_and_prune != NULL, {});
+
+    Rect rects[BROADPHASE_SUITE_RECTS_COUNT];
+    bool skip[BROADPHASE_SUITE_RECTS_COUNT];
+    bool still[BROADPHASE_SUITE_RECTS_COUNT];
+
+    srand(42);
+    broadphase_suite_random_rects(rects, skip, still, BROADPHASE_SUITE_RECTS_COUNT);
+
+    // The order is kept between the calls, so the rects are moved a
+    // bit every step to exercise the insertion sort
+    for (size_t step = 0; step < 5; ++step) {
+        for (size_t i = 0; i < BROADPHASE_SUITE_RECTS_COUNT; ++i) {
+            rects[i].x += rand_float_range(-20.0f, 20.0f);
+            rects[i].y += rand_float_range(-20.0f, 20.0f);
+        }
+
+        const float margin = step % 2 == 0 ? 0.0f : BROADPHASE_SUITE_MARGIN;
+        const size_t *pairs = NULL;
+        size_t pairs_count = 0;
+        ASSERT_TRUE(sweep_and_prune_find_pairs(sweep_and_prune, rects, skip, still,
+                                               BROADPHASE_SUITE_RECTS_COUNT,
+                                               margin, &pairs, &pairs_count) == 0, {});
+
+        if (broadphase_suite_check_pairs(rects, skip, still, BROADPHASE_SUITE_RECTS_COUNT,
+                                         margin, pairs, pairs_count) < 0) {
+            return -1;
+        }
+    }
+
+    destroy_sweep_and_prune(sweep_and_prune);
+
+    return 0;
+}
+
+TEST_SUITE(broadphase_suite)
+{
+    TEST_RUN(spatial_grid_pairs_test);
+    TEST_RUN(sweep_and_prune_pairs_test);
+
+    return 0;
+}
+
+#endif  // BROADPHASE_SUITE_H_
@@ -3,6 +3,12 @@
 #include "parser_suite.h"
 #include "interpreter_suite.h"
 #include "scope_suite.h"
+#include "aabb_tree_suite.h"
+#include "broadphase_suite.h"
+#include "rect_suite.h"
+#include "platforms_suite.h"
+#include "rigid_bodies_suite.h"
+#include "regions_suite.h"
 
 TEST_MAIN()
 {
@@ -10,6 +16,12 @@ TEST_MAIN()
     TEST_RUN(parser_suite);
     TEST_RUN(interpreter_suite);
     TEST_RUN(scope_suite);
+    TEST_RUN(aabb_tree_suite);
+    TEST_RUN(broadphase_suite);
+    TEST_RUN(rect_suite);
+    TEST_RUN(platforms_suite);
+    TEST_RUN(rigid_bodies_suite);
+    TEST_RUN(regions_suite);
 
     return 0;
 }
@@ -0,0 +1,49 @@
+#ifndef PLATFORMS_SUITE_H_
+#define PLATFORMS_SUITE_H_
+
+#include <stdio.h>
+
+#include "test.h"
+#include "color.h"
+#include "game/level/platforms.h"
+
+TEST(platforms_snap_rect_neighbour_test)
+{
+    const Rect rects[] = {
+        // A floor the object sinks into
+        rect(0.0f, 100.0f, 100.0f, 10.0f),
+        // A ledge right above the object, it only overlaps the
+        // object after the object is snapped out of the floor
+        rect(40.0f, 85.0f, 10.0f, 8.0f)
+    };
+    const Color colors[] = {
+        rgba(1.0f, 1.0f, 1.0f, 1.0f),
+        rgba(1.0f, 1.0f, 1.0f, 1.0f)
+    };
+
+    Platforms *platforms = create_platforms(rects, colors, 2);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    Rect object = rect(40.0f, 95.0f, 10.0f, 10.0f);
+    const Vec mask = platforms_snap_rect(platforms, &object);
+
+    // The floor pushes the object up to 90, then the ledge pushes it
+    // back down to 93, just like the scan in the order of the file
+    ASSERT_FLOATEQ(40.0f, object.x, 1e-4f);
+    ASSERT_FLOATEQ(93.0f, object.y, 1e-4f);
+    ASSERT_FLOATEQ(1.0f, mask.x, 1e-6f);
+    ASSERT_FLOATEQ(0.0f, mask.y, 1e-6f);
+
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST_SUITE(platforms_suite)
+{
+    TEST_RUN(platforms_snap_rect_neighbour_test);
+
+    return 0;
+}
+
+#endif  // PLATFORMS_SUITE_H_
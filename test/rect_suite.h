@@ -0,0 +1,79 @@
+#ifndef RECT_SUITE_H_
+#define RECT_SUITE_H_
+
+#include <stdio.h>
+
+#include "test.h"
+#include "math/rect.h"
+
+TEST(rect_time_of_impact_test)
+{
+    const Rect obstacle = rect(100.0f, 0.0f, 10.0f, 100.0f);
+    Vec mask = vec(1.0f, 1.0f);
+
+    // Hits the left side of the obstacle half way
+    const float t = rect_time_of_impact(
+        rect(0.0f, 40.0f, 10.0f, 10.0f),
+        vec(180.0f, 0.0f),
+        obstacle,
+        &mask);
+    ASSERT_FLOATEQ(0.5f, t, 1e-4f);
+    ASSERT_FLOATEQ(0.0f, mask.x, 1e-6f);
+    ASSERT_FLOATEQ(1.0f, mask.y, 1e-6f);
+
+    // Tunnels through the obstacle within one step
+    mask = vec(1.0f, 1.0f);
+    ASSERT_FLOATEQ(0.09f, rect_time_of_impact(
+                       rect(0.0f, 40.0f, 10.0f, 10.0f),
+                       vec(1000.0f, 0.0f),
+                       obstacle,
+                       &mask), 1e-4f);
+    ASSERT_FLOATEQ(0.0f, mask.x, 1e-6f);
+
+    // Falls on top of a floor
+    mask = vec(1.0f, 1.0f);
+    ASSERT_FLOATEQ(0.25f, rect_time_of_impact(
+                       rect(0.0f, -50.0f, 10.0f, 10.0f),
+                       vec(0.0f, 160.0f),
+                       rect(-100.0f, 0.0f, 200.0f, 10.0f),
+                       &mask), 1e-4f);
+    ASSERT_FLOATEQ(1.0f, mask.x, 1e-6f);
+    ASSERT_FLOATEQ(0.0f, mask.y, 1e-6f);
+
+    // Stops short of the obstacle
+    mask = vec(1.0f, 1.0f);
+    ASSERT_TRUE(isinf(rect_time_of_impact(
+                          rect(0.0f, 40.0f, 10.0f, 10.0f),
+                          vec(50.0f, 0.0f),
+                          obstacle,
+                          &mask)), {});
+
+    // Passes above the obstacle
+    ASSERT_TRUE(isinf(rect_time_of_impact(
+                          rect(0.0f, -40.0f, 10.0f, 10.0f),
+                          vec(200.0f, 0.0f),
+                          obstacle,
+                          &mask)), {});
+
+    // Moves away from the obstacle
+    ASSERT_TRUE(isinf(rect_time_of_impact(
+                          rect(120.0f, 40.0f, 10.0f, 10.0f),
+                          vec(100.0f, 0.0f),
+                          obstacle,
+                          &mask)), {});
+
+    // The mask is left alone when nothing is hit
+    ASSERT_FLOATEQ(1.0f, mask.x, 1e-6f);
+    ASSERT_FLOATEQ(1.0f, mask.y, 1e-6f);
+
+    return 0;
+}
+
+TEST_SUITE(rect_suite)
+{
+    TEST_RUN(rect_time_of_impact_test);
+
+    return 0;
+}
+
+#endif  // RECT_SUITE_H_
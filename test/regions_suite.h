@@ -0,0 +1,154 @@
+#ifndef REGIONS_SUITE_H_
+#define REGIONS_SUITE_H_
+
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "game/level/regions/overlaps.h"
+
+#define REGIONS_SUITE_MAX_VISITED 16
+
+typedef struct {
+    Overlap overlaps[REGIONS_SUITE_MAX_VISITED];
+    size_t count;
+} Regions_suite_visited;
+
+static void regions_suite_visit(void *param, const Overlap *overlap)
+{
+    Regions_suite_visited *visited = param;
+    if (visited->count < REGIONS_SUITE_MAX_VISITED) {
+        visited->overlaps[visited->count] = *overlap;
+    }
+    visited->count++;
+}
+
+static int regions_suite_check_visited(const Regions_suite_visited *visited,
+                                       const Overlap *expected,
+                                       size_t expected_count)
+{
+    ASSERT_TRUE(visited->count == expected_count, {
+        fprintf(stderr, "Visited %lu overlaps instead of %lu\n",
+                visited->count, expected_count);
+    });
+
+    for (size_t i = 0; i < expected_count; ++i) {
+        ASSERT_TRUE(visited->overlaps[i].occupant == expected[i].occupant &&
+                    visited->overlaps[i].region == expected[i].region, {
+            fprintf(stderr, "Overlap %lu is (%lu, %lu) instead of (%lu, %lu)\n", i,
+                    visited->overlaps[i].occupant, visited->overlaps[i].region,
+                    expected[i].occupant, expected[i].region);
+        });
+    }
+
+    return 0;
+}
+
+TEST(overlaps_difference_test)
+{
+    // The tree reports the regions in its own order
+    Overlap previous[] = {
+        {2, 1}, {0, 3}, {0, 1}
+    };
+    Overlap current[] = {
+        {5, 0}, {2, 2}, {0, 3}, {2, 1}
+    };
+    overlaps_sort(previous, 3);
+    overlaps_sort(current, 4);
+
+    Regions_suite_visited entered = { .count = 0 };
+    overlaps_difference(current, 4, previous, 3, regions_suite_visit, &entered);
+    const Overlap expected_entered[] = { {2, 2}, {5, 0} };
+    if (regions_suite_check_visited(&entered, expected_entered, 2) < 0) {
+        return -1;
+    }
+
+    Regions_suite_visited left = { .count = 0 };
+    overlaps_difference(previous, 3, current, 4, regions_suite_visit, &left);
+    const Overlap expected_left[] = { {0, 1} };
+    if (regions_suite_check_visited(&left, expected_left, 1) < 0) {
+        return -1;
+    }
+
+    // Everything enters when there was nothing before
+    Regions_suite_visited all = { .count = 0 };
+    overlaps_difference(current, 4, NULL, 0, regions_suite_visit, &all);
+    if (regions_suite_check_visited(&all, current, 4) < 0) {
+        return -1;
+    }
+
+    // Nothing changes, nothing enters
+    Regions_suite_visited none = { .count = 0 };
+    overlaps_difference(current, 4, current, 4, regions_suite_visit, &none);
+    if (regions_suite_check_visited(&none, NULL, 0) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    Regions_suite_visited entered;
+    Regions_suite_visited left;
+} Regions_suite_changes;
+
+static void regions_suite_enter(void *param, const Overlap *overlap)
+{
+    Regions_suite_changes *changes = param;
+    regions_suite_visit(&changes->entered, overlap);
+}
+
+static void regions_suite_leave(void *param, const Overlap *overlap)
+{
+    Regions_suite_changes *changes = param;
+    regions_suite_visit(&changes->left, overlap);
+}
+
+TEST(overlaps_changes_test)
+{
+    // The player (0) is followed by the bodies 5 and 2, watched in
+    // that order, so the occupants are not sorted by their ids
+    const Overlap gathered[] = {
+        {0, 1}, {6, 2}, {6, 0}, {3, 0}
+    };
+
+    Overlap previous[4];
+    memcpy(previous, gathered, sizeof(gathered));
+    Regions_suite_changes first = {
+        .entered = { .count = 0 },
+        .left = { .count = 0 }
+    };
+    overlaps_changes(previous, 4, NULL, 0,
+                     regions_suite_enter, regions_suite_leave, &first);
+    const Overlap expected_entered[] = { {0, 1}, {3, 0}, {6, 0}, {6, 2} };
+    if (regions_suite_check_visited(&first.entered, expected_entered, 4) < 0 ||
+        regions_suite_check_visited(&first.left, NULL, 0) < 0) {
+        return -1;
+    }
+
+    // Nothing moved, so nothing enters or leaves
+    Overlap overlaps[4];
+    memcpy(overlaps, gathered, sizeof(gathered));
+    Regions_suite_changes second = {
+        .entered = { .count = 0 },
+        .left = { .count = 0 }
+    };
+    overlaps_changes(overlaps, 4, previous, 4,
+                     regions_suite_enter, regions_suite_leave, &second);
+    if (regions_suite_check_visited(&second.entered, NULL, 0) < 0 ||
+        regions_suite_check_visited(&second.left, NULL, 0) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+TEST_SUITE(regions_suite)
+{
+    TEST_RUN(overlaps_difference_test);
+    TEST_RUN(overlaps_changes_test);
+
+    return 0;
+}
+
+#endif  // REGIONS_SUITE_H_
@@ -0,0 +1,350 @@
+#ifndef RIGID_BODIES_SUITE_H_
+#define RIGID_BODIES_SUITE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "color.h"
+#include "game/level/platforms.h"
+#include "game/level/rigid_bodies.h"
+
+TEST(rigid_bodies_fast_landing_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(1);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    const RigidBodyId id = rigid_bodies_add(
+        rigid_bodies,
+        rect(0.0f, 0.0f, 10.0f, 10.0f),
+        color);
+
+    // Falls 200 units in one step, right through the floor
+    rigid_bodies_apply_force(rigid_bodies, id, vec(0.0f, 20000.0f));
+    rigid_bodies_integrate_all(rigid_bodies, 0.1f);
+    ASSERT_TRUE(rigid_bodies_collide(rigid_bodies, platforms) == 0, {});
+
+    const Rect hitbox = rigid_bodies_hitbox(rigid_bodies, id);
+    ASSERT_FLOATEQ(90.0f, hitbox.y, 1e-3f);
+    ASSERT_FLOATEQ(0.0f, rigid_bodies_velocity(rigid_bodies, id).y, 1e-6f);
+    ASSERT_TRUE(rigid_bodies_touches_ground(rigid_bodies, id), {
+        fprintf(stderr, "The body is not grounded on the landing step\n");
+    });
+
+    destroy_rigid_bodies(rigid_bodies);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST(rigid_bodies_asleep_stats_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(2);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    // A stack of two boxes resting on the floor
+    rigid_bodies_add(rigid_bodies, rect(0.0f, 90.0f, 10.0f, 10.0f), color);
+    rigid_bodies_add(rigid_bodies, rect(0.0f, 80.0f, 10.0f, 10.0f), color);
+
+    for (size_t step = 0; step < 100; ++step) {
+        rigid_bodies_apply_omniforce(rigid_bodies, vec(0.0f, 1500.0f));
+        rigid_bodies_integrate_all(rigid_bodies, 1.0f / 60.0f);
+        ASSERT_TRUE(rigid_bodies_collide(rigid_bodies, platforms) == 0, {});
+
+        if (step == 0) {
+            ASSERT_TRUE(rigid_bodies_stats(rigid_bodies).contacts > 0, {});
+        }
+    }
+
+    // The stack is asleep by now, so the last step did nothing
+    const RigidBodiesStats stats = rigid_bodies_stats(rigid_bodies);
+    ASSERT_TRUE(stats.contacts == 0, {
+        fprintf(stderr, "Contacts: %lu\n", stats.contacts);
+    });
+    ASSERT_TRUE(stats.collisions == 0, {
+        fprintf(stderr, "Collisions: %lu\n", stats.collisions);
+    });
+    ASSERT_TRUE(stats.solver_iterations == 0, {
+        fprintf(stderr, "Solver iterations: %lu\n", stats.solver_iterations);
+    });
+
+    destroy_rigid_bodies(rigid_bodies);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST(rigid_bodies_removed_ids_test)
+{
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(4);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    const RigidBodyId a = rigid_bodies_add(rigid_bodies, rect(0.0f, 0.0f, 10.0f, 10.0f), color);
+    const RigidBodyId b = rigid_bodies_add(rigid_bodies, rect(100.0f, 0.0f, 10.0f, 10.0f), color);
+    const RigidBodyId c = rigid_bodies_add(rigid_bodies, rect(200.0f, 0.0f, 10.0f, 10.0f), color);
+
+    rigid_bodies_remove(rigid_bodies, b);
+    ASSERT_FALSE(rigid_bodies_is_alive(rigid_bodies, b), {});
+
+    // The new body reuses the index of the removed one, but the old
+    // id must not point at it
+    const RigidBodyId d = rigid_bodies_add(rigid_bodies, rect(300.0f, 0.0f, 10.0f, 10.0f), color);
+    ASSERT_TRUE(d != b, {});
+    ASSERT_FALSE(rigid_bodies_is_alive(rigid_bodies, b), {});
+    ASSERT_TRUE(rigid_bodies_is_alive(rigid_bodies, d), {});
+
+    // Compaction moves the bodies, but not their ids
+    rigid_bodies_remove(rigid_bodies, a);
+    rigid_bodies_compact(rigid_bodies);
+    ASSERT_FALSE(rigid_bodies_is_alive(rigid_bodies, a), {});
+    ASSERT_TRUE(rigid_bodies_is_alive(rigid_bodies, c), {});
+    ASSERT_TRUE(rigid_bodies_is_alive(rigid_bodies, d), {});
+    ASSERT_FLOATEQ(200.0f, rigid_bodies_hitbox(rigid_bodies, c).x, 1e-6f);
+    ASSERT_FLOATEQ(300.0f, rigid_bodies_hitbox(rigid_bodies, d).x, 1e-6f);
+
+    destroy_rigid_bodies(rigid_bodies);
+
+    return 0;
+}
+
+TEST(rigid_bodies_grow_test)
+{
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(1);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    RigidBodyId ids[100];
+    for (size_t i = 0; i < 100; ++i) {
+        ids[i] = rigid_bodies_add(
+            rigid_bodies,
+            rect((float) i * 20.0f, 0.0f, 10.0f, 10.0f),
+            color);
+
+        // Every other body is removed, so the pool is compacted
+        // before it has to grow
+        if (i % 2 == 1) {
+            rigid_bodies_remove(rigid_bodies, ids[i]);
+        }
+    }
+
+    for (size_t i = 0; i < 100; ++i) {
+        ASSERT_TRUE(rigid_bodies_is_alive(rigid_bodies, ids[i]) == (i % 2 == 0), {
+            fprintf(stderr, "Body %lu\n", i);
+        });
+
+        if (i % 2 == 0) {
+            ASSERT_FLOATEQ((float) i * 20.0f, rigid_bodies_hitbox(rigid_bodies, ids[i]).x, 1e-6f);
+        }
+    }
+
+    destroy_rigid_bodies(rigid_bodies);
+
+    return 0;
+}
+
+static int rigid_bodies_suite_steps(RigidBodies *rigid_bodies,
+                                    const Platforms *platforms,
+                                    size_t count)
+{
+    for (size_t step = 0; step < count; ++step) {
+        rigid_bodies_apply_omniforce(rigid_bodies, vec(0.0f, 1500.0f));
+        rigid_bodies_integrate_all(rigid_bodies, 1.0f / 60.0f);
+        if (rigid_bodies_collide(rigid_bodies, platforms) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+TEST(rigid_bodies_remove_wakes_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(2);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    const RigidBodyId bottom = rigid_bodies_add(rigid_bodies, rect(0.0f, 90.0f, 10.0f, 10.0f), color);
+    const RigidBodyId top = rigid_bodies_add(rigid_bodies, rect(0.0f, 80.0f, 10.0f, 10.0f), color);
+
+    // Puts the stack to sleep
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 100) == 0, {});
+    ASSERT_TRUE(rigid_bodies_stats(rigid_bodies).contacts == 0, {});
+
+    // The top box lost its support and falls onto the floor
+    rigid_bodies_remove(rigid_bodies, bottom);
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 60) == 0, {});
+    ASSERT_FLOATEQ(90.0f, rigid_bodies_hitbox(rigid_bodies, top).y, 1e-2f);
+
+    destroy_rigid_bodies(rigid_bodies);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST(rigid_bodies_snapshot_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(2);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    const RigidBodyId a = rigid_bodies_add(rigid_bodies, rect(0.0f, 0.0f, 10.0f, 10.0f), color);
+    const RigidBodyId b = rigid_bodies_add(rigid_bodies, rect(5.0f, -30.0f, 10.0f, 10.0f), color);
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 5) == 0, {});
+
+    void *snapshot = malloc(rigid_bodies_snapshot_size(rigid_bodies));
+    ASSERT_TRUE(snapshot != NULL, {});
+    rigid_bodies_snapshot(rigid_bodies, snapshot);
+
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 20) == 0, {});
+    const Rect a1 = rigid_bodies_hitbox(rigid_bodies, a);
+    const Rect b1 = rigid_bodies_hitbox(rigid_bodies, b);
+
+    // The steps after the restore repeat the steps after the snapshot
+    ASSERT_TRUE(rigid_bodies_restore(rigid_bodies, snapshot) == 0, {});
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 20) == 0, {});
+    const Rect a2 = rigid_bodies_hitbox(rigid_bodies, a);
+    const Rect b2 = rigid_bodies_hitbox(rigid_bodies, b);
+    ASSERT_TRUE(memcmp(&a1, &a2, sizeof(Rect)) == 0, {});
+    ASSERT_TRUE(memcmp(&b1, &b2, sizeof(Rect)) == 0, {});
+
+    // Adding a body and removing it again leaves the same number of
+    // bodies, but the snapshot must still be refused
+    const RigidBodyId c = rigid_bodies_add(rigid_bodies, rect(50.0f, 0.0f, 10.0f, 10.0f), color);
+    ASSERT_TRUE(rigid_bodies_restore(rigid_bodies, snapshot) < 0, {});
+    rigid_bodies_remove(rigid_bodies, c);
+    ASSERT_TRUE(rigid_bodies_restore(rigid_bodies, snapshot) < 0, {});
+
+    // The refused snapshot leaves the bodies alone
+    const Rect a3 = rigid_bodies_hitbox(rigid_bodies, a);
+    ASSERT_TRUE(memcmp(&a2, &a3, sizeof(Rect)) == 0, {});
+
+    free(snapshot);
+    destroy_rigid_bodies(rigid_bodies);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST(rigid_bodies_restore_frozen_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *rigid_bodies = create_rigid_bodies(1);
+    ASSERT_TRUE(rigid_bodies != NULL, {});
+
+    // The snapshot is taken while the body is frozen, like the body
+    // of a dying player
+    const RigidBodyId id = rigid_bodies_add(rigid_bodies, rect(0.0f, 0.0f, 10.0f, 10.0f), color);
+    rigid_bodies_freeze(rigid_bodies, id, true);
+
+    void *snapshot = malloc(rigid_bodies_snapshot_size(rigid_bodies));
+    ASSERT_TRUE(snapshot != NULL, {});
+    rigid_bodies_snapshot(rigid_bodies, snapshot);
+
+    // Restored after the respawn the body must still fall
+    rigid_bodies_freeze(rigid_bodies, id, false);
+    ASSERT_TRUE(rigid_bodies_restore(rigid_bodies, snapshot) == 0, {});
+    ASSERT_TRUE(rigid_bodies_suite_steps(rigid_bodies, platforms, 5) == 0, {});
+    ASSERT_TRUE(rigid_bodies_hitbox(rigid_bodies, id).y > 0.0f, {
+        fprintf(stderr, "The body is still frozen after the restore\n");
+    });
+
+    free(snapshot);
+    destroy_rigid_bodies(rigid_bodies);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST(rigid_bodies_threads_stats_test)
+{
+    const Rect floor = rect(-100.0f, 100.0f, 300.0f, 10.0f);
+    const Color color = rgba(1.0f, 1.0f, 1.0f, 1.0f);
+
+    Platforms *platforms = create_platforms(&floor, &color, 1);
+    ASSERT_TRUE(platforms != NULL, {});
+
+    RigidBodies *single = create_rigid_bodies(4);
+    ASSERT_TRUE(single != NULL, {});
+    RigidBodies *threaded = create_rigid_bodies(4);
+    ASSERT_TRUE(threaded != NULL, {});
+    ASSERT_TRUE(rigid_bodies_set_threads_count(threaded, 2) == 0, {});
+
+    // Two stacks far apart from each other are two islands
+    RigidBodyId ids[4];
+    for (size_t i = 0; i < 4; ++i) {
+        const Rect body = rect((float) (i / 2) * 100.0f, 60.0f - (float) (i % 2) * 12.0f, 10.0f, 10.0f);
+        ids[i] = rigid_bodies_add(single, body, color);
+        ASSERT_TRUE(rigid_bodies_add(threaded, body, color) == ids[i], {});
+    }
+
+    for (size_t step = 0; step < 30; ++step) {
+        ASSERT_TRUE(rigid_bodies_suite_steps(single, platforms, 1) == 0, {});
+        ASSERT_TRUE(rigid_bodies_suite_steps(threaded, platforms, 1) == 0, {});
+
+        const RigidBodiesStats expected = rigid_bodies_stats(single);
+        const RigidBodiesStats actual = rigid_bodies_stats(threaded);
+        ASSERT_TRUE(expected.solver_iterations == actual.solver_iterations, {
+            fprintf(stderr, "Step %lu: %lu solver iterations without threads, %lu with\n",
+                    step, expected.solver_iterations, actual.solver_iterations);
+        });
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_FLOATEQ(rigid_bodies_hitbox(single, ids[i]).y,
+                       rigid_bodies_hitbox(threaded, ids[i]).y,
+                       1e-6f);
+    }
+
+    destroy_rigid_bodies(threaded);
+    destroy_rigid_bodies(single);
+    destroy_platforms(platforms);
+
+    return 0;
+}
+
+TEST_SUITE(rigid_bodies_suite)
+{
+    TEST_RUN(rigid_bodies_fast_landing_test);
+    TEST_RUN(rigid_bodies_asleep_stats_test);
+    TEST_RUN(rigid_bodies_removed_ids_test);
+    TEST_RUN(rigid_bodies_grow_test);
+    TEST_RUN(rigid_bodies_remove_wakes_test);
+    TEST_RUN(rigid_bodies_snapshot_test);
+    TEST_RUN(rigid_bodies_restore_frozen_test);
+    TEST_RUN(rigid_bodies_threads_stats_test);
+
+    return 0;
+}
+
+#endif  // RIGID_BODIES_SUITE_H_